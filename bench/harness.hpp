@@ -0,0 +1,224 @@
+#ifndef SERVAL_BENCH__HARNESS_HPP
+#define SERVAL_BENCH__HARNESS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Minimal benchmark harness, no dependencies beyond the standard library
+ *
+ * Each benchmark is a function running its operation `iterations` times. The harness calibrates the iteration count to
+ * fill a sample period, takes several samples and reports the median and fastest time per operation.
+ *
+ * Results are written as JSON, one benchmark per line so that the compare mode (and simple scripts) can read them back
+ * without a JSON parser:
+ *
+ *     {"benchmarks": [
+ *     {"name": "message/3_params", "ns_per_op": 4.21, "min_ns_per_op": 4.17, "iterations": 4194304},
+ *     ...
+ *     ]}
+ */
+namespace serval::bench {
+    using BenchFn = void(*)(std::uint64_t iterations);
+
+    struct Benchmark {
+        const char* name;
+        BenchFn fn;
+    };
+
+    struct Result {
+        std::string name;
+        double ns_per_op;
+        double min_ns_per_op;
+        std::uint64_t iterations;
+    };
+
+    struct Options {
+        double sample_ms = 20.0;
+        unsigned samples = 7;
+    };
+
+    /**
+     * @brief Prevent the compiler from optimising away a value
+     *
+     * @tparam T
+     * @param value
+     */
+    template <typename T>
+    inline void do_not_optimize (const T& value) {
+#if defined(_MSC_VER)
+        const volatile char* sink = reinterpret_cast<const volatile char*>(&value);
+        (void)*sink;
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+
+    inline double time_ns (BenchFn fn, std::uint64_t iterations) {
+        const auto start = std::chrono::steady_clock::now();
+        fn(iterations);
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    inline Result run (const Benchmark& benchmark, const Options& options) {
+        // Double the iteration count until one sample takes long enough to time reliably
+        std::uint64_t iterations = 1;
+        const double target_ns = options.sample_ms * 1e6;
+        for (;;) {
+            const auto elapsed = time_ns(benchmark.fn, iterations);
+            if (elapsed >= target_ns || iterations >= (std::uint64_t{1} << 40)) {
+                break;
+            }
+            iterations *= elapsed < target_ns / 16 ? 8 : 2;
+        }
+        std::vector<double> samples;
+        for (unsigned sample = 0; sample < options.samples; ++sample) {
+            samples.push_back(time_ns(benchmark.fn, iterations) / double(iterations));
+        }
+        std::sort(samples.begin(), samples.end());
+        return {benchmark.name, samples[samples.size() / 2], samples.front(), iterations};
+    }
+
+    inline void write_json (std::FILE* out, const std::vector<Result>& results) {
+        std::fprintf(out, "{\"benchmarks\": [\n");
+        for (std::size_t index = 0; index < results.size(); ++index) {
+            const auto& result = results[index];
+            std::fprintf(out, "{\"name\": \"%s\", \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"iterations\": %llu}%s\n",
+                result.name.c_str(), result.ns_per_op, result.min_ns_per_op, static_cast<unsigned long long>(result.iterations),
+                index + 1 < results.size() ? "," : "");
+        }
+        std::fprintf(out, "]}\n");
+    }
+
+    /**
+     * @brief Read results written by write_json()
+     *
+     * @param path
+     * @param results
+     * @return true The file was read
+     * @return false The file could not be opened
+     */
+    inline bool read_json (const char* path, std::vector<Result>& results) {
+        std::ifstream in{path};
+        if (!in) {
+            return false;
+        }
+        std::string line;
+        while (std::getline(in, line)) {
+            const auto name = line.find("\"name\": \"");
+            const auto ns = line.find("\"ns_per_op\": ");
+            if (name == std::string::npos || ns == std::string::npos) {
+                continue;
+            }
+            const auto name_start = name + 9;
+            const auto name_end = line.find('"', name_start);
+            results.push_back({line.substr(name_start, name_end - name_start), std::strtod(line.c_str() + ns + 13, nullptr), 0, 0});
+        }
+        return true;
+    }
+
+    /**
+     * @brief Print each result relative to a baseline
+     *
+     * @param baseline
+     * @param results
+     * @param threshold Fractional slowdown counted as a regression, eg 0.1 for 10%
+     * @return unsigned The number of regressions
+     */
+    inline unsigned compare (const std::vector<Result>& baseline, const std::vector<Result>& results, double threshold) {
+        unsigned regressions = 0;
+        std::printf("%-40s %12s %12s %9s\n", "benchmark", "baseline ns", "current ns", "change");
+        for (const auto& result : results) {
+            const auto base = std::find_if(baseline.begin(), baseline.end(), [&result](const auto& other){ return other.name == result.name; });
+            if (base == baseline.end() || base->ns_per_op <= 0) {
+                std::printf("%-40s %12s %12.3f %9s\n", result.name.c_str(), "-", result.ns_per_op, "new");
+                continue;
+            }
+            const auto change = result.ns_per_op / base->ns_per_op - 1.0;
+            const bool regressed = change > threshold;
+            regressions += regressed;
+            std::printf("%-40s %12.3f %12.3f %+8.1f%%%s\n", result.name.c_str(), base->ns_per_op, result.ns_per_op, change * 100.0, regressed ? "  REGRESSION" : "");
+        }
+        return regressions;
+    }
+
+    /**
+     * @brief Command line entry point
+     *
+     *     --filter <text>          Only run benchmarks whose name contains <text>
+     *     --json <path>            Write results to <path> (default: stdout)
+     *     --compare <path>         Compare against results previously written with --json
+     *     --threshold <fraction>   Slowdown counted as a regression in compare mode (default: 0.1)
+     *     --sample-ms <ms>         Duration of each sample (default: 20)
+     *
+     * @return int 0 on success, 1 if compare mode found regressions, 2 on bad arguments
+     */
+    inline int main (int argc, char** argv, const std::vector<Benchmark>& benchmarks) {
+        Options options;
+        std::string_view filter;
+        const char* json_path = nullptr;
+        const char* compare_path = nullptr;
+        double threshold = 0.1;
+        for (int arg = 1; arg < argc; ++arg) {
+            const std::string_view flag = argv[arg];
+            if (arg + 1 >= argc) {
+                std::fprintf(stderr, "Missing value for %s\n", argv[arg]);
+                return 2;
+            }
+            const char* value = argv[++arg];
+            if (flag == "--filter") {
+                filter = value;
+            } else if (flag == "--json") {
+                json_path = value;
+            } else if (flag == "--compare") {
+                compare_path = value;
+            } else if (flag == "--threshold") {
+                threshold = std::strtod(value, nullptr);
+            } else if (flag == "--sample-ms") {
+                options.sample_ms = std::strtod(value, nullptr);
+            } else {
+                std::fprintf(stderr, "Unknown option %s\n", argv[arg - 1]);
+                return 2;
+            }
+        }
+
+        std::vector<Result> results;
+        for (const auto& benchmark : benchmarks) {
+            if (filter.empty() || std::string_view{benchmark.name}.find(filter) != std::string_view::npos) {
+                results.push_back(run(benchmark, options));
+                std::fprintf(stderr, "%-40s %10.3f ns/op\n", benchmark.name, results.back().ns_per_op);
+            }
+        }
+
+        if (json_path) {
+            if (auto* file = std::fopen(json_path, "w")) {
+                write_json(file, results);
+                std::fclose(file);
+            } else {
+                std::fprintf(stderr, "Could not write %s\n", json_path);
+                return 2;
+            }
+        } else if (!compare_path) {
+            write_json(stdout, results);
+        }
+
+        if (compare_path) {
+            std::vector<Result> baseline;
+            if (!read_json(compare_path, baseline)) {
+                std::fprintf(stderr, "Could not read %s\n", compare_path);
+                return 2;
+            }
+            return compare(baseline, results, threshold) ? 1 : 0;
+        }
+        return 0;
+    }
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include "harness.hpp"
+#include "mock_engine.hpp"
+
+#include <serval/sdk/graphics/draw_list.hpp>
+
+#include <random>
+
+/********************************************************************************
+ * SDK hot path benchmarks, run against the in-tree mock engine
+ *
+ *     serval-bench --json baseline.json
+ *     serval-bench --compare baseline.json --threshold 0.05
+ ********************************************************************************/
+
+namespace {
+    using serval::bench::do_not_optimize;
+
+    struct BenchCommand {
+        static constexpr serval::Id CommandTypeID = "bench/command"_hs;
+        glm::vec3 position;
+        serval::Scalar speed;
+    };
+
+    struct BenchResource {
+        static constexpr serval::Id ResourceTypeID = "bench/resource"_hs;
+        std::uint64_t value;
+    };
+
+    serval::bench::MockRuntime& runtime () {
+        static serval::bench::MockRuntime instance;
+        return instance;
+    }
+
+    /* **** Messages and commands **** */
+
+    void message_no_params (std::uint64_t iterations) {
+        auto& api = runtime();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            api.message(entt::entity(i), "bench/ping"_hs);
+        }
+        do_not_optimize(api.messagesSent());
+    }
+
+    void message_3_params (std::uint64_t iterations) {
+        auto& api = runtime();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            api.message(entt::entity(i), "bench/hit"_hs, std::int32_t(i), serval::Scalar(1.5f), glm::vec3{1.0f, 2.0f, 3.0f});
+        }
+        do_not_optimize(api.messagesSent());
+    }
+
+    void message_5_params (std::uint64_t iterations) {
+        auto& api = runtime();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            api.message(entt::entity(i), "bench/full"_hs, std::int32_t(i), serval::Scalar(1.5f), glm::vec3{1.0f, 2.0f, 3.0f}, serval::Id{"bench/key"_hs}, true);
+        }
+        do_not_optimize(api.messagesSent());
+    }
+
+    void populate_parameters_buffer (std::uint64_t iterations) {
+        alignas(16) std::byte buffer[64];
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            msghelpers::populate_parameters_buffer(buffer, std::int32_t(i), serval::Scalar(1.5f), glm::vec3{1.0f, 2.0f, 3.0f});
+            do_not_optimize(buffer);
+        }
+    }
+
+    void command (std::uint64_t iterations) {
+        auto& api = runtime();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            auto& cmd = api.command<BenchCommand>("bench/target"_hs);
+            cmd.position = glm::vec3{1.0f, 2.0f, 3.0f};
+            cmd.speed = serval::Scalar(i);
+            do_not_optimize(cmd);
+        }
+    }
+
+    /* **** Attributes and variants **** */
+
+    serval::bench::MockAttributes& attributes () {
+        static serval::bench::MockAttributes instance = [](){
+            serval::bench::MockAttributes attributes;
+            attributes.set("health"_hs, std::int32_t(100));
+            attributes.set("speed"_hs, serval::Scalar(4.5f));
+            attributes.set("target"_hs, serval::Id{"bench/target"_hs});
+            attributes.set("position"_hs, glm::vec3{1.0f, 2.0f, 3.0f});
+            attributes.set("alive"_hs, true);
+            return attributes;
+        }();
+        return instance;
+    }
+
+    void attributes_try_get (std::uint64_t iterations) {
+        auto& attribs = attributes();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            glm::vec3 position;
+            do_not_optimize(attribs.try_get("position"_hs, position));
+            do_not_optimize(position);
+        }
+    }
+
+    void attributes_set (std::uint64_t iterations) {
+        auto& attribs = attributes();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(attribs.set("speed"_hs, serval::Scalar(i)));
+        }
+    }
+
+    void attributes_update (std::uint64_t iterations) {
+        auto& attribs = attributes();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            attribs.update<serval::variant::Type::Integer>("health"_hs, [](auto& health){ health -= 1; });
+        }
+        do_not_optimize(attribs);
+    }
+
+    void variant_cast (std::uint64_t iterations) {
+        const glm::vec3 value{1.0f, 2.0f, 3.0f};
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(serval::variant::cast(serval::variant::Type::Vec3, &value));
+        }
+    }
+
+    void variant_copy_into (std::uint64_t iterations) {
+        const serval::variant::Container value{glm::vec3{1.0f, 2.0f, 3.0f}};
+        glm::vec3 out;
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(serval::variant::copy_into(value, serval::variant::Type::Vec3, &out));
+            do_not_optimize(out);
+        }
+    }
+
+    /* **** Ids and resources **** */
+
+    void id_from (std::uint64_t iterations) {
+        const std::string name = "characters/player/idle";
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(serval::Id::from(name));
+        }
+    }
+
+    struct ResourceFixture {
+        std::vector<BenchResource> resources;
+        std::vector<serval::Handle> handles;
+
+        ResourceFixture () : resources(4096) {
+            std::vector<void*> pointers;
+            for (auto& resource : resources) {
+                pointers.push_back(&resource);
+            }
+            handles = runtime().addResources(BenchResource::ResourceTypeID, pointers);
+            std::shuffle(handles.begin(), handles.end(), std::mt19937{7});
+        }
+    };
+
+    ResourceFixture& resource_fixture () {
+        static ResourceFixture fixture;
+        return fixture;
+    }
+
+    void resolve_runtime (std::uint64_t iterations) {
+        const auto& handles = resource_fixture().handles;
+        const auto& api = runtime();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(api.resolve<BenchResource>(handles[i & (handles.size() - 1)]));
+        }
+    }
+
+    void resolve_view (std::uint64_t iterations) {
+        const auto& handles = resource_fixture().handles;
+        const auto view = runtime().resources<BenchResource>();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            do_not_optimize(view.resolve(handles[i & (handles.size() - 1)]));
+        }
+    }
+
+    /* **** Streams **** */
+
+    // Stream records are written and read with the SDK's serialization format, the stream transport itself is engine-side
+    struct StreamRecord {
+        entt::entity entity;
+        serval::Id type;
+        glm::vec3 position;
+    };
+
+    void stream_write (std::uint64_t iterations) {
+        serval::Writer writer;
+        writer.reserve(64 * 1024);
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            if ((i & 1023) == 0) {
+                writer.clear();
+            }
+            writer.write(StreamRecord{entt::entity(i), "bench/event"_hs, glm::vec3{1.0f, 2.0f, 3.0f}});
+        }
+        do_not_optimize(writer);
+    }
+
+    void stream_read (std::uint64_t iterations) {
+        serval::Writer writer;
+        for (std::uint32_t i = 0; i < 1024; ++i) {
+            writer.write(StreamRecord{entt::entity(i), "bench/event"_hs, glm::vec3{1.0f, 2.0f, 3.0f}});
+        }
+        const auto data = writer.data();
+        serval::Reader reader{data};
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            if (reader.done()) {
+                reader = serval::Reader{data};
+            }
+            StreamRecord record;
+            do_not_optimize(reader.read(record));
+            do_not_optimize(record);
+        }
+    }
+
+    /* **** Rendering (null backend: sort and batch only, nothing is submitted) **** */
+
+    void draw_list_10k (std::uint64_t iterations) {
+        std::mt19937 rng{3};
+        struct Item {
+            components::graphics::Layer layer;
+            components::graphics::Model model;
+            components::graphics::Material material;
+        };
+        std::vector<Item> items(10000);
+        for (auto& item : items) {
+            item.layer.layer = std::uint8_t(rng() % 3);
+            item.model.mesh = serval::Handle(rng() % 50);
+            item.material = {};
+            item.material.albedo = serval::Handle(rng() % 20);
+        }
+        serval::graphics::DrawList draw_list;
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            draw_list.clear();
+            for (std::size_t index = 0; index < items.size(); ++index) {
+                draw_list.add(entt::entity(index), items[index].layer, items[index].model, items[index].material);
+            }
+            draw_list.sort();
+            draw_list.build();
+            do_not_optimize(draw_list.batches().size());
+        }
+    }
+}
+
+int main (int argc, char** argv)
+{
+    const std::vector<serval::bench::Benchmark> benchmarks{
+        {"message/no_params", message_no_params},
+        {"message/3_params", message_3_params},
+        {"message/5_params", message_5_params},
+        {"msghelpers/populate_parameters_buffer", populate_parameters_buffer},
+        {"command", command},
+        {"attributes/try_get", attributes_try_get},
+        {"attributes/set", attributes_set},
+        {"attributes/update", attributes_update},
+        {"variant/cast", variant_cast},
+        {"variant/copy_into", variant_copy_into},
+        {"id/from", id_from},
+        {"resolve/runtime", resolve_runtime},
+        {"resolve/view", resolve_view},
+        {"stream/write", stream_write},
+        {"stream/read", stream_read},
+        {"draw_list/10k", draw_list_10k},
+    };
+    return serval::bench::main(argc, argv, benchmarks);
+}
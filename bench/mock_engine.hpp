@@ -0,0 +1,193 @@
+#ifndef SERVAL_BENCH__MOCK_ENGINE_HPP
+#define SERVAL_BENCH__MOCK_ENGINE_HPP
+
+#include <serval/serval.hpp>
+#include <serval/sdk/assets/attributes.hpp>
+
+#include <entt/entity/registry.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace serval::bench {
+    class MockRuntime;
+    class MockAttributes;
+}
+
+/**
+ * @brief Runtime with in-memory, single-threaded stand-ins for the engine side of the API
+ * Only the paths exercised by the benchmarks do real work: commands and message parameters are bump-allocated from
+ * buffers which are recycled when full, and resources live in a fixed table. Everything else is a no-op or throws.
+ *
+ */
+class serval::bench::MockRuntime final : public serval::Runtime {
+public:
+    static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+    MockRuntime () : m_commands(BUFFER_SIZE), m_parameters(BUFFER_SIZE) {}
+
+    /**
+     * @brief Replace the resource table with the given resources
+     *
+     * @param type The ResourceTypeID
+     * @param resources Pointers to the resources, which must outlive the runtime
+     * @return std::vector<serval::Handle> A handle to each resource
+     */
+    std::vector<serval::Handle> addResources (serval::Id type, const std::vector<void*>& resources) {
+        m_resources = resources;
+        m_generations.assign(resources.size(), 1);
+        m_slots = {type, std::uint32_t(resources.size()), m_resources.data(), m_generations.data()};
+        std::vector<serval::Handle> handles;
+        for (std::uint32_t index = 0; index < resources.size(); ++index) {
+            handles.push_back(serval::handles::make(index, 1));
+        }
+        return handles;
+    }
+
+    std::uint64_t messagesSent () const { return m_messages_sent; }
+
+    void asyncTask (serval::AsyncTask, serval::TaskPriority) override {}
+    void loadEntity (serval::Id, serval::Id) override {}
+    serval::Id loadNamedEntity (serval::Id, const char*, serval::Id) override { return serval::Id::INVALID; }
+    serval::Id loadActor (serval::Id, const char*) override { return serval::Id::INVALID; }
+    void createEntity (serval::EntityConstructor) override {}
+    void createEntity (serval::Id, serval::EntityConstructor) override {}
+    void destroyEntity (entt::entity) override {}
+    entt::entity lookup (serval::Id) const override { return entt::null; }
+    void tagEntity (entt::entity, serval::Id) override {}
+    serval::Version version () const override { return 0; }
+    void prioritiseAsset (serval::Handle, serval::Scalar) override {}
+    void releaseAsset (serval::Handle) override {}
+    serval::AssetState assetState (serval::Handle) const override { return serval::AssetState::Invalid; }
+    serval::AssetMemoryUsage assetMemoryUsage () const override { return {}; }
+    void saveGame (serval::Id, serval::Id, serval::SaveKind) override {}
+    serval::SaveSegment saveSegment () const override { return {}; }
+    bool saving () const override { return false; }
+    void pushState (serval::Id) override {}
+    void popState () override {}
+    void setState (serval::Id) override {}
+    serval::Id currentState () const override { return serval::Id::INVALID; }
+    bool inState (serval::Id) const override { return false; }
+    const serval::StreamReader& stream (serval::Id) override { throw std::logic_error("Streams are not supported by the mock engine"); }
+    const serval::Timeline& timeline () override { throw std::logic_error("Timelines are not supported by the mock engine"); }
+    serval::TimerWheel& timers () override { return m_timers; }
+    serval::TimelineTree& timelines () override { return m_timelines; }
+    const serval::SpatialIndex& spatial () const override { return m_spatial; }
+    serval::ScratchArena& scratch () override { return m_scratch; }
+    serval::ScratchStats scratchStats (serval::Id) const override { return m_scratch.stats(); }
+    void performanceCounters (serval::PerformanceCounters& counters) const override { counters = {}; }
+    void resetPerformanceCounters () override {}
+    serval::MemoryUsage memoryUsage (serval::Id extension_name, serval::Id system_name) const override { return {{extension_name, system_name}, nullptr, nullptr, 0, 0, 0, 0}; }
+    void memoryReport (std::vector<serval::MemoryUsage>& usage) const override { usage.clear(); }
+
+private:
+    std::byte* make_command (serval::Id, serval::Id, std::size_t size) override {
+        return bump(m_commands, m_commands_used, size);
+    }
+
+    void send_simple_command (serval::Id, serval::Id, serval::Id) override {}
+
+    void send_message (entt::entity, serval::Id, std::uint32_t) const override {
+        ++m_messages_sent;
+    }
+
+    void get_parameters_buffer (std::size_t size, serval::ParametersBuffer* info) const override {
+        info->buffer = bump(m_parameters, m_parameters_used, size);
+        info->metadata = 0;
+    }
+
+    serval::Handle request_asset (serval::Id, serval::Id, serval::Scalar, serval::Id) override { return serval::Handle{}; }
+    serval::Handle request_asset_at (serval::Id, serval::Id, const glm::vec3&, serval::Id) override { return serval::Handle{}; }
+
+    const serval::ResourceSlots* get_resource_slots (serval::Id) const override {
+        return &m_slots;
+    }
+
+    void mark_changed (entt::entity, entt::id_type) override {}
+    void mark_all_changed (std::span<const entt::entity>, entt::id_type) override {}
+    std::span<const entt::entity> changed_entities (entt::id_type, serval::Version) const override { return {}; }
+    bool owning_group (std::span<const entt::id_type>) const override { return false; }
+    const void* component_snapshots (entt::id_type, serval::Scalar&) const override { return nullptr; }
+    entt::registry& registry () override { return m_registry; }
+
+    static std::byte* bump (std::vector<std::byte>& buffer, std::size_t& used, std::size_t size) {
+        size = (size + 15) & ~std::size_t{15};
+        if (used + size > buffer.size()) {
+            used = 0;
+        }
+        auto* ptr = buffer.data() + used;
+        used += size;
+        return ptr;
+    }
+
+    mutable std::vector<std::byte> m_commands;
+    mutable std::size_t m_commands_used = 0;
+    mutable std::vector<std::byte> m_parameters;
+    mutable std::size_t m_parameters_used = 0;
+    mutable std::uint64_t m_messages_sent = 0;
+    std::vector<void*> m_resources;
+    std::vector<std::uint16_t> m_generations;
+    serval::ResourceSlots m_slots{};
+    serval::SpatialIndex m_spatial;
+    serval::ScratchArena m_scratch;
+    serval::TimerWheel m_timers;
+    serval::TimelineTree m_timelines;
+    entt::registry m_registry;
+};
+
+/**
+ * @brief Attributes stored in a small flat array, like an attributes asset with a handful of keys
+ *
+ */
+class serval::bench::MockAttributes final : public serval::Attributes {
+private:
+    struct Value {
+        serval::Id key;
+        serval::variant::TypeId type;
+        alignas(16) std::byte data[16];
+    };
+
+    serval::variant::TypeId get_type (serval::Id key) const override {
+        const auto* value = find(key);
+        return value ? value->type : serval::variant::to_id(serval::variant::Type::Invalid);
+    }
+
+    bool read (serval::Id key, serval::variant::TypeId type_id, void* out_value) const override {
+        const auto* value = find(key);
+        if (value == nullptr || value->type != type_id) {
+            return false;
+        }
+        std::memcpy(out_value, value->data, serval::variant::size(serval::variant::from_id(type_id)));
+        return true;
+    }
+
+    bool write (serval::Id key, serval::variant::TypeId type_id, const void* data) override {
+        auto* value = find(key);
+        if (value == nullptr) {
+            value = &m_values.emplace_back(Value{key, type_id, {}});
+        } else if (value->type != type_id) {
+            return false;
+        }
+        std::memcpy(value->data, data, serval::variant::size(serval::variant::from_id(type_id)));
+        return true;
+    }
+
+    const Value* find (serval::Id key) const {
+        for (const auto& value : m_values) {
+            if (value.key == key) {
+                return &value;
+            }
+        }
+        return nullptr;
+    }
+
+    Value* find (serval::Id key) {
+        return const_cast<Value*>(std::as_const(*this).find(key));
+    }
+
+    std::vector<Value> m_values;
+};
+
+#endif
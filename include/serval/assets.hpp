@@ -3,5 +3,6 @@
 
 #include "sdk/assets/attributes.hpp"
 #include "sdk/assets/text.hpp"
+#include "sdk/assets/pack.hpp"
 
 #endif
\ No newline at end of file
@@ -3,8 +3,21 @@
 
 #include "types.hpp"
 #include "type_utils.hpp"
+#include "variant.hpp"
+#include "message_helpers.hpp"
+#include "resources.hpp"
+#include "arena.hpp"
+#include "memory.hpp"
+#include "log.hpp"
+#include "diagnostics.hpp"
+#include "scheduling.hpp"
+#include "fixed_step.hpp"
+#include <entt/entity/registry.hpp>
 #include <magic_enum/magic_enum.hpp>
 #include <spdlog/spdlog.h>
+#include <new>
+#include <span>
+#include <stdexcept>
 
 class ImGuiContext;
 
@@ -22,6 +35,9 @@ namespace serval {
     class GameSetup;
     class Runtime;
 
+    // Spatial queries
+    class SpatialIndex;
+
     // Streams
     class StreamWriter;
     class StreamReader;
@@ -29,12 +45,84 @@ namespace serval {
     // Commands
     class CommandReader;
 
+    // Timers
+    class TimerWheel;
+    class TimelineTree;
+
     // Enums
     enum class StreamWriterAccess {
         Single,
         Multiple,
     };
 
+    enum class AssetState : std::uint8_t {
+        Invalid,   // Unknown handle, or the asset has been evicted
+        Queued,    // Waiting for a streaming worker
+        Loading,   // Being read and decoded by a streaming worker
+        Resident,  // Loaded, resolve() will return the asset
+        Failed,    // The asset could not be loaded
+    };
+
+    /**
+     * @brief Notification published to a stream when a requested asset has finished loading (or failed to load)
+     * 
+     */
+    struct AssetLoaded {
+        serval::Handle handle;
+        serval::Id asset;
+        serval::AssetState state;
+    };
+
+    /**
+     * @brief Snapshot of the asset streaming memory usage
+     * 
+     */
+    struct AssetMemoryUsage {
+        std::size_t resident_bytes;
+        std::size_t budget_bytes;
+        std::uint32_t resident_assets;
+        std::uint32_t pending_requests;
+    };
+
+    /**
+     * @brief Notification published to a stream when a background save has been written (or has failed)
+     * 
+     */
+    struct SaveCompleted {
+        serval::Id slot;
+        std::uint64_t bytes;
+        bool success;
+    };
+
+    enum class SaveKind : std::uint8_t {
+        Full,  // Write a new base snapshot, replacing the slot's contents
+        Delta, // Append only what changed since the slot's previous save (a full save if the slot is empty)
+    };
+
+    /**
+     * @brief The save segment being written by onSave or read by onLoad
+     * A save slot holds a base snapshot followed by zero or more delta segments
+     * 
+     */
+    struct SaveSegment {
+        std::uint32_t sequence;  // 0 for the base snapshot, then 1, 2, ... for each delta segment
+        serval::Version since;   // A delta segment holds changes made after this version (0 for the base snapshot)
+        serval::Version until;   // The version at which the segment was captured
+    };
+
+    /**
+     * @brief Summary of a hot reload, returned by Init::endReload()
+     * 
+     */
+    struct ReloadStats {
+        float milliseconds;          // Time from beginReload() to endReload()
+        std::uint32_t tasks_rebound; // Tasks re-registered with unchanged declarations, whose delegates were rebound in place
+        std::uint32_t tasks_added;   // Tasks registered for the first time, or whose declarations changed
+        std::uint32_t tasks_removed; // Tasks which were not re-registered
+        std::uint32_t states_preserved; // Persistent state blocks carried over from before the reload
+        std::uint32_t states_reset;     // Persistent state blocks reset because their layout changed
+    };
+
     /**
      * @brief Extension initialisation
      * 
@@ -43,6 +131,7 @@ namespace serval {
         Init* engine_init_api;
         const std::shared_ptr<spdlog::logger> logger;
         ImGuiContext* imgui_context;
+        serval::log::Backend* log_backend;
     };
 }
 
@@ -78,6 +167,38 @@ public:
             return *this;
         }
 
+        /**
+         * @brief Declare that the task reads the storages of one or more component types
+         * The scheduler derives conflicts from component declarations directly, the same way as from `ro`/`rw` resources.
+         * Component types declared together in one call are also counted as a co-accessed set: the engine creates owning
+         * groups for frequently co-accessed sets, which Runtime::each<Components...>() then iterates.
+         * 
+         * @tparam Components The component types read by the task
+         * @return TaskBuilder& 
+         */
+        template <typename... Components>
+        TaskBuilder& reads () {
+            static_assert(sizeof...(Components) > 0, "Declare at least one component type");
+            const entt::id_type types[]{serval::component_type_id<Components>()...};
+            m_api->add_component_access(m_task_name, types, false);
+            return *this;
+        }
+
+        /**
+         * @brief Declare that the task reads and writes the storages of one or more component types
+         * See reads(). Required for Runtime::write<Component>() and Runtime::each_mut().
+         * 
+         * @tparam Components The component types written by the task
+         * @return TaskBuilder& 
+         */
+        template <typename... Components>
+        TaskBuilder& writes () {
+            static_assert(sizeof...(Components) > 0, "Declare at least one component type");
+            const entt::id_type types[]{serval::component_type_id<Components>()...};
+            m_api->add_component_access(m_task_name, types, true);
+            return *this;
+        }
+
         /**
          * @brief Declare that the task acts as a sync point
          * WARNING: This is an advanced feature that may have unexpected impact on the scheduling order
@@ -154,6 +275,7 @@ private:
     virtual void add_ro_resource (const char* task_name, serval::Id resource) = 0;
     virtual void add_rw_resource (const char* task_name, serval::Id resource) = 0;
     virtual void add_sync_point (const char* task_name) = 0;
+    virtual void add_component_access (const char* task_name, std::span<const entt::id_type> component_types, bool write) = 0;
     friend class TaskBuilder;
 };
 
@@ -178,6 +300,39 @@ public:
      */
     virtual serval::Id addScheduler (const char* scheduler_name, float interval_seconds) = 0;
 
+    /**
+     * @brief Set the time budget of a scheduler's frame
+     * Tasks are always dispatched longest remaining dependency chain first, using their measured run times (see
+     * serval::TaskGraph). The budget only limits deferred asyncTask() work: it runs while the frame is within budget.
+     * 
+     * @param scheduler_name The name of the scheduler
+     * @param milliseconds The budget, 0 to use the scheduler's interval
+     */
+    virtual void setSchedulerBudget (const char* scheduler_name, float milliseconds) = 0;
+
+    /**
+     * @brief Set how far a fixed-frequency scheduler may catch up after a long frame
+     * If a frame needs more than `max_steps` steps, only `max_steps` are run and the remaining time is dropped, so the
+     * simulation slows down instead of spiralling (see serval::FixedStepClock). The default is 5.
+     * 
+     * @param scheduler_name The name of the scheduler
+     * @param max_steps The most steps run in one frame, at least 1
+     */
+    virtual void setSchedulerCatchUp (const char* scheduler_name, std::uint32_t max_steps) = 0;
+
+    /**
+     * @brief Snapshot components at the end of each of a fixed-frequency scheduler's steps, for Runtime::interpolated()
+     * Each component type may only be interpolated for one scheduler.
+     * 
+     * @tparam Components The component types, currently components::core::Position and components::core::Orientation
+     * @param scheduler_name The name of the scheduler which writes the components
+     */
+    template <typename... Components>
+    void interpolate (const char* scheduler_name) {
+        static_assert(((std::is_same_v<Components, components::core::Position> || std::is_same_v<Components, components::core::Orientation>) && ...), "Only Position and Orientation can be interpolated");
+        (add_interpolated_component(scheduler_name, serval::component_type_id<Components>()), ...);
+    }
+
     /**
      * @brief Register a new game state class with the engine
      * 
@@ -213,7 +368,7 @@ public:
      */
     template <typename System>
     serval::Id addSystem (const char* system_name) {
-        static_assert(std::is_base_of<serval::SystemEvents, Class>::value, "System must be derived from SystemEvents");
+        static_assert(std::is_base_of<serval::SystemEvents, System>::value, "System must be derived from SystemEvents");
         return add_system(system_name, serval::makeFactoryFn<System>());
     }
 
@@ -245,10 +400,101 @@ public:
         return add_notification_stream(stream_name, magic_enum::enum_underlying(access));
     }
 
+    /**
+     * @brief Set the resident memory budget for streamed assets
+     * When the budget is exceeded, unreferenced assets are evicted in least-recently-used order.
+     * Referenced assets are never evicted, so the budget may be exceeded if every resident asset is in use.
+     * 
+     * @param bytes The budget in bytes
+     */
+    virtual void setAssetMemoryBudget (std::size_t bytes) = 0;
+
+    /**
+     * @brief Register a component type to be included in save games
+     * Saved components are captured at a frame boundary by copy-on-write snapshots of their storage, and serialised on
+     * background workers, so they must be trivially copyable.
+     * 
+     * @tparam Component The component type to save
+     * @param component_name The name of the component, used as its section tag in the save
+     */
+    template <typename Component>
+    void addSavedComponent (const char* component_name) {
+        static_assert(std::is_trivially_copyable_v<Component>, "Saved components must be trivially copyable");
+        add_saved_component(component_name, serval::component_type_id<Component>(), sizeof(Component), alignof(Component));
+    }
+
+    /**
+     * @brief Set how many delta segments a save slot may accumulate before it is compacted
+     * Compaction merges the base snapshot and its deltas into a new base snapshot on a background worker
+     * 
+     * @param max_deltas The maximum number of delta segments per slot (0 to disable compaction)
+     */
+    virtual void setSaveCompaction (std::uint32_t max_deltas) = 0;
+
+    /**
+     * @brief Get the memory counter for allocations owned by one of this extension's systems
+     * The engine tags the counter with the extension being loaded. Systems, game states, streams and scratch memory used by
+     * the system's tasks are recorded against it automatically; pass it to serval::TrackedAllocator or serval::SlabAllocator to
+     * track the extension's own containers and pools too. The counter lives until the extension is unloaded.
+     * 
+     * @param system_name The name of the system, or 0 for allocations not owned by any one system
+     * @return serval::MemoryCounter& 
+     */
+    virtual serval::MemoryCounter& memoryCounter (serval::Id system_name=0) = 0;
+
+    /**
+     * @brief Get a block of extension state which is owned by the engine and preserved across hot reloads
+     * The block is carried over if the key, size, alignment and layout version all match the block from before the reload,
+     * otherwise it is value-initialised. Bump `layout_version` whenever State changes in a way that sizeof(State) doesn't catch.
+     * 
+     * @tparam State A trivially copyable type holding the extension's state
+     * @param key A unique name for the state block
+     * @param layout_version The version of State's layout
+     * @return State& The state, valid until the extension is unloaded
+     */
+    template <typename State>
+    State& persistentState (serval::Id key, std::uint32_t layout_version=0) {
+        static_assert(std::is_trivially_copyable_v<State>, "Persistent state must be trivially copyable");
+        bool preserved = false;
+        void* ptr = persistent_state(key, sizeof(State), alignof(State), layout_version, preserved);
+        if (!preserved) {
+            return *new (ptr) State{};
+        }
+        return *std::launder(reinterpret_cast<State*>(ptr));
+    }
+
+    /**
+     * @brief Start a hot reload of the calling extension
+     * The engine keeps the extension's registrations (schedulers, tasks, systems, state classes and streams) and diffs them
+     * against those made until endReload(): unchanged registrations are kept with their delegates rebound in place, changed
+     * ones are re-created and any that are not made again are removed.
+     * Called by the SDK's plugin entrypoint, extensions should not call this directly.
+     * 
+     */
+    virtual void beginReload () = 0;
+
+    /**
+     * @brief Finish a hot reload started by beginReload()
+     * 
+     * @return serval::ReloadStats 
+     */
+    virtual serval::ReloadStats endReload () = 0;
+
+    /**
+     * @brief Check if a hot reload has been started and not yet finished
+     * 
+     * @return true 
+     * @return false 
+     */
+    virtual bool reloading () const = 0;
+
 private:
     virtual serval::Id add_game_state_class (const char* class_name, serval::FactoryFn<serval::StateEvents> factory) = 0;
     virtual serval::Id add_system (const char* system_name, serval::FactoryFn<serval::SystemEvents> factory) = 0;
     virtual serval::StreamWriter& add_notification_stream (const char* stream_name, magic_enum::underlying_type_t<serval::StreamWriterAccess> access) = 0;
+    virtual void add_saved_component (const char* component_name, entt::id_type component_type, std::size_t size, std::size_t alignment) = 0;
+    virtual void add_interpolated_component (const char* scheduler_name, entt::id_type component_type) = 0;
+    virtual void* persistent_state (serval::Id key, std::size_t size, std::size_t alignment, std::uint32_t layout_version, bool& preserved) = 0;
 };
 
 
@@ -259,6 +505,14 @@ private:
 class serval::SystemSetup : public serval::TaskSetup {
 public:
     virtual ~SystemSetup () {}
+
+    /**
+     * @brief Declare that this system's onLoad must run after another system's onLoad has completed
+     * onLoad handlers of systems without load dependencies are run concurrently
+     * 
+     * @param system_name The name of the system to load after
+     */
+    virtual void loadAfter (serval::Id system_name) = 0;
 };
 
 
@@ -291,10 +545,13 @@ public:
 
     /**
      * @brief Execute an asynchronous task
+     * Deferred tasks only run on workers which would otherwise be idle, while the scheduler's frame budget (see
+     * Init::setSchedulerBudget()) has time left, and otherwise carry over to the next frame.
      * 
      * @param task The delegate to execute
+     * @param priority Whether the task may be deferred to idle time
      */
-    virtual void asyncTask (serval::AsyncTask task) = 0;
+    virtual void asyncTask (serval::AsyncTask task, serval::TaskPriority priority=serval::TaskPriority::Normal) = 0;
 
     /**
      * @brief Execute an asynchronous task
@@ -303,12 +560,13 @@ public:
      * @tparam Func The function to bind
      * @tparam Instance 
      * @param instance The instance of the object to which Func belongs
+     * @param priority Whether the task may be deferred to idle time
      */
     template <auto Func, typename Instance>
-    void asyncTask (Instance* instance) {
+    void asyncTask (Instance* instance, serval::TaskPriority priority=serval::TaskPriority::Normal) {
         serval::AsyncTask task;
         task.connect<Func>(instance);
-        asyncTask(task);
+        asyncTask(task, priority);
     }
 
 
@@ -382,6 +640,236 @@ public:
     virtual void tagEntity (entt::entity entity, serval::Id tag) = 0;
 
 
+    /* ************************************* */
+    /* **** Component Access API        **** */
+    /* ************************************* */
+
+    /**
+     * @brief The calling task's change version
+     * Advanced by the engine before every task and system run, so each run has its own version and components written
+     * through write<Component>() are stamped with it. Store it at the start of a run and pass it to changed_since() on the
+     * next run to see every write made in between, including writes made later in the same tick.
+     *
+     * @return serval::Version
+     */
+    virtual serval::Version version () const = 0;
+
+    /**
+     * @brief Read-only access to an entity's component
+     *
+     * @tparam Component The component type to read
+     * @param entity The entity to read from
+     * @return const Component&
+     */
+    template <typename Component>
+    const Component& read (entt::entity entity) {
+        return registry().template get<Component>(entity);
+    }
+
+    /**
+     * @brief Read-write access to an entity's component, marking it as changed in the current version
+     * NOTE: The calling task must have declared access to the component's type with TaskBuilder::writes()
+     *
+     * @tparam Component The component type to write
+     * @param entity The entity to write to
+     * @return Component&
+     */
+    template <typename Component>
+    Component& write (entt::entity entity) {
+        // Only stamp the component once it is known to exist
+        auto& component = registry().template get<Component>(entity);
+        mark_changed(entity, serval::component_type_id<Component>());
+        return component;
+    }
+
+    /**
+     * @brief Get the entities whose Component was written after `since`, ie by runs with a newer version
+     * The engine skips whole chunks whose version is not newer than `since`, so the cost scales with the number of changes.
+     * Passing the caller's own version() from its previous run excludes its own writes from that run.
+     * The returned span is owned by the engine and is valid until the end of the current frame.
+     *
+     * @tparam Component The component type to check for changes
+     * @param since The version last observed by the caller (usually version() at the start of its previous run)
+     * @return std::span<const entt::entity> The changed entities
+     */
+    template <typename Component>
+    std::span<const entt::entity> changed_since (serval::Version since) const {
+        return changed_entities(serval::component_type_id<Component>(), since);
+    }
+
+    /**
+     * @brief Call a function for every entity which has all of the given components, with read-only access to them
+     * Iterates the engine's owning group for exactly this component set if it created one (see TaskBuilder::reads()),
+     * which packs the components contiguously, otherwise a view. Either way the function receives
+     * `(entt::entity, const Components&...)` or `(const Components&...)`, as with entt. Use each_mut() to write them.
+     *
+     * @tparam Components The component types to iterate, which the calling task must have declared
+     * @tparam Func
+     * @param func
+     */
+    template <typename... Components, typename Func>
+    void each (Func&& func) {
+        static_assert(sizeof...(Components) > 0, "Iterate at least one component type");
+        const entt::id_type types[]{serval::component_type_id<Components>()...};
+        auto& registry = this->registry();
+        if (owning_group(types)) {
+            registry.template group<const Components...>().each(std::forward<Func>(func));
+        } else {
+            registry.template view<const Components...>().each(std::forward<Func>(func));
+        }
+    }
+
+    /**
+     * @brief Call a function for every entity which has all of the given components, with read-write access to them
+     * As each(), but the function receives `(entt::entity, Components&...)` or `(Components&...)` and every visited
+     * component is marked as changed in the current version, as if written through write<Component>().
+     * NOTE: The calling task must have declared access to the component types with TaskBuilder::writes()
+     *
+     * @tparam Components The component types to iterate and write, which can't be empty (tag) types
+     * @tparam Func
+     * @param func
+     */
+    template <typename... Components, typename Func>
+    void each_mut (Func&& func) {
+        static_assert(sizeof...(Components) > 0, "Iterate at least one component type");
+        static_assert((!std::is_empty_v<Components> && ...), "Tag components have no data to write");
+        static_assert((!std::is_const_v<Components> && ...), "Use each() for read-only components");
+        const entt::id_type types[]{serval::component_type_id<Components>()...};
+        // The visited entities are stamped in bulk once iteration is done, rather than with a call into the engine each
+        auto visit = [this, &func, &types](auto&& range, std::size_t capacity) {
+            const std::span<entt::entity> written = scratch<entt::entity>(capacity);
+            std::size_t count = 0;
+            range.each([&func, &written, &count](entt::entity entity, Components&... components) {
+                written[count++] = entity;
+                if constexpr (std::is_invocable_v<Func&, entt::entity, Components&...>) {
+                    func(entity, components...);
+                } else {
+                    func(components...);
+                }
+            });
+            for (const auto type : types) {
+                mark_all_changed(written.first(count), type);
+            }
+        };
+        auto& registry = this->registry();
+        if (owning_group(types)) {
+            auto group = registry.template group<Components...>();
+            visit(group, group.size());
+        } else {
+            auto view = registry.template view<Components...>();
+            visit(view, view.size_hint());
+        }
+    }
+
+
+    /* ************************************* */
+    /* **** Asset Streaming API         **** */
+    /* ************************************* */
+
+    /**
+     * @brief Asynchronously stream in an asset with an explicit priority and publish a serval::AssetLoaded notification to a stream when done
+     * The returned handle is valid immediately and holds a reference to the asset, but only resolves (with resolve<Asset>()) once the asset is resident.
+     * Requesting an asset which is already resident or in flight returns the existing handle and adds a reference.
+     * 
+     * @tparam Asset The type of asset to load
+     * @param asset_name The name of the asset to load
+     * @param priority Higher priorities are loaded first
+     * @param stream The stream on which to notify when the asset is loaded (0 to disable notification)
+     * @return serval::Handle The handle to the asset
+     */
+    template <typename Asset>
+    serval::Handle requestAsset (serval::Id asset_name, serval::Scalar priority, serval::Id stream=0) {
+        static_assert(serval::is_asset_v<Asset>, "Must be an asset type, declared with ASSET()");
+        return request_asset(asset_name, Asset::AssetTypeId, priority, stream);
+    }
+
+    /**
+     * @brief Asynchronously stream in an asset, prioritised by distance, and publish a serval::AssetLoaded notification to a stream when done
+     * The priority is recomputed by the engine each frame from the distance between `position` and the active camera.
+     * 
+     * @tparam Asset The type of asset to load
+     * @param asset_name The name of the asset to load
+     * @param position The world-space position at which the asset is needed
+     * @param stream The stream on which to notify when the asset is loaded (0 to disable notification)
+     * @return serval::Handle The handle to the asset
+     */
+    template <typename Asset>
+    serval::Handle requestAsset (serval::Id asset_name, const glm::vec3& position, serval::Id stream=0) {
+        static_assert(serval::is_asset_v<Asset>, "Must be an asset type, declared with ASSET()");
+        return request_asset_at(asset_name, Asset::AssetTypeId, position, stream);
+    }
+
+    /**
+     * @brief Change the priority of a queued asset request
+     * Has no effect if the asset is already loading or resident
+     * 
+     * @param handle The handle returned by requestAsset()
+     * @param priority Higher priorities are loaded first
+     */
+    virtual void prioritiseAsset (serval::Handle handle, serval::Scalar priority) = 0;
+
+    /**
+     * @brief Release a reference to an asset
+     * Once all references are released the asset becomes a candidate for eviction, or its request is cancelled if not yet loaded
+     * 
+     * @param handle The handle returned by requestAsset()
+     */
+    virtual void releaseAsset (serval::Handle handle) = 0;
+
+    /**
+     * @brief Get the streaming state of an asset
+     * 
+     * @param handle The handle returned by requestAsset()
+     * @return serval::AssetState 
+     */
+    virtual serval::AssetState assetState (serval::Handle handle) const = 0;
+
+    /**
+     * @brief Get the current streaming memory usage
+     * 
+     * @return serval::AssetMemoryUsage 
+     */
+    virtual serval::AssetMemoryUsage assetMemoryUsage () const = 0;
+
+
+    /* ************************************* */
+    /* **** Save Game API               **** */
+    /* ************************************* */
+
+    /**
+     * @brief Save the game in the background and publish a serval::SaveCompleted notification to a stream when done
+     * At the next frame boundary the engine calls onSaveBegin/onSave/onSaveEnd on states and systems, which should only copy
+     * their state into the writer, and takes copy-on-write snapshots of the saved component storages. Serialisation,
+     * compression and file writes then run on background workers while the simulation continues.
+     * Requests made while a save is in progress are queued.
+     * 
+     * A delta save only appends the saved components and entities which were created, changed or destroyed since the slot's
+     * previous save. Loading replays the base snapshot followed by each delta segment in order.
+     * 
+     * @param slot The save slot to write
+     * @param stream The stream on which to notify when the save is written (0 to disable notification)
+     * @param kind Whether to write a full snapshot or append a delta segment
+     */
+    virtual void saveGame (serval::Id slot, serval::Id stream=0, serval::SaveKind kind=serval::SaveKind::Full) = 0;
+
+    /**
+     * @brief Describe the segment currently being saved or loaded
+     * Only valid from within onSave and onLoad. During a delta save, systems should only write state which changed after
+     * `since`, eg using changed_since<Component>(segment.since).
+     * 
+     * @return serval::SaveSegment 
+     */
+    virtual serval::SaveSegment saveSegment () const = 0;
+
+    /**
+     * @brief Check if a background save is in progress
+     * 
+     * @return true A save has been requested and not yet written
+     * @return false No save is in progress
+     */
+    virtual bool saving () const = 0;
+
+
     /* ************************************* */
     /* **** Game State API              **** */
     /* ************************************* */
@@ -445,7 +933,7 @@ public:
         if EXPECT_TAKEN(ptr) {
             return *reinterpret_cast<Command*>(ptr);
         }
-        warn("Command does not exist or does not match size");
+        LOG_WARN("Command does not exist or does not match size");
         throw std::runtime_error("Command does not exist or does not match size");
     }
 
@@ -500,11 +988,11 @@ public:
     void post (entt::entity target_actor, Params&&... params) {
         using Component = serval::class_of_t<decltype(Field)>;
         const auto& registry = this->registry();
-        if (registry.all_of<Component>(entity)) {
-            const auto& component = registry.get<Component>(entity);
-            const auto message = component.*Field;
-            if (message != serval::Id::INVALID) {
-                message(target_actor, message, std::forward<Params>(params)...);
+        if (registry.all_of<Component>(target_actor)) {
+            const auto& component = registry.get<Component>(target_actor);
+            const serval::Id message_id = component.*Field;
+            if (message_id != serval::Id::INVALID) {
+                message(target_actor, message_id, std::forward<Params>(params)...);
             }
         }
     }
@@ -531,22 +1019,164 @@ public:
      */
     virtual const serval::Timeline& timeline () = 0;
 
+    /**
+     * @brief Get the timer wheel of the current timeline, to send callbacks, commands and messages after a delay
+     * Delays are in the timeline's time, so timers stop while it is paused and follow its absolute_scale(). The engine
+     * fires the timers which came due at the start of each of the scheduler's frames, before any of its tasks run.
+     * Include serval/sdk/timers.hpp to use the wheel.
+     * 
+     * @return serval::TimerWheel& 
+     */
+    virtual serval::TimerWheel& timers () = 0;
+
+    /**
+     * @brief Get the tree of gameplay timelines, eg per-entity timelines parented to bullet time zones
+     * The engine updates the tree once per frame, after which all of its queries are inline reads of cached values.
+     * Change the tree only from tasks which are ordered with each other. Include serval/sdk/timeline_tree.hpp to use it.
+     * 
+     * @return serval::TimelineTree& 
+     */
+    virtual serval::TimelineTree& timelines () = 0;
+
+    /**
+     * @brief Get an entity's component blended between the last two steps of the fixed-frequency scheduler which writes it
+     * The blend factor is that scheduler's Timeline::alpha(), so a render-rate task sees smooth motion from a lower rate
+     * simulation. Falls back to the component's current value if it isn't snapshotted (see Init::interpolate()) or the
+     * entity wasn't captured on the latest step.
+     * 
+     * @tparam Component The component type
+     * @param entity The entity to read
+     * @return Component The blended value
+     */
+    template <typename Component>
+    Component interpolated (entt::entity entity) {
+        serval::Scalar alpha;
+        const auto* snapshots = static_cast<const serval::SnapshotBuffer<Component>*>(component_snapshots(serval::component_type_id<Component>(), alpha));
+        Component value;
+        if (EXPECT_TAKEN(snapshots) && snapshots->interpolate(entity, alpha, value)) {
+            return value;
+        }
+        return registry().template get<Component>(entity);
+    }
+
+
+    /* ************************************* */
+    /* **** Spatial Query API           **** */
+    /* ************************************* */
+
+    /**
+     * @brief Get the spatial index of all entities with a core::Position
+     * The index is rebuilt by the engine once per frame, before any scheduler runs, and is read-only for the rest of the frame.
+     * Queries are inline and safe to run concurrently from parallel tasks (see serval::SpatialIndex in spatial.hpp).
+     *
+     * @return const serval::SpatialIndex&
+     */
+    virtual const serval::SpatialIndex& spatial () const = 0;
+
+
+    /* ************************************* */
+    /* **** Scratch Memory API          **** */
+    /* ************************************* */
+
+    /**
+     * @brief Get the calling worker thread's scratch arena
+     * Memory allocated from the arena is valid until the end of the current frame, when the engine resets every arena.
+     * Use it for temporary per-task buffers instead of std::vector or new. The arena must not be shared with other threads.
+     *
+     * @return serval::ScratchArena&
+     */
+    virtual serval::ScratchArena& scratch () = 0;
+
+    /**
+     * @brief Allocate a temporary array from the calling worker thread's scratch arena
+     *
+     * @tparam T A trivially destructible type
+     * @param count The number of elements
+     * @return serval::ScratchSpan<T> Valid until the end of the current frame
+     */
+    template <typename T>
+    serval::ScratchSpan<T> scratch (std::size_t count) {
+        return scratch().allocate<T>(count);
+    }
+
+    /**
+     * @brief Scratch memory used by a task the last time it ran
+     * The engine resets the worker's statistics before running each task and records them when the task returns
+     *
+     * @param task_name The name of the task
+     * @return serval::ScratchStats Allocation count, bytes allocated and the arena's high water mark while the task ran
+     */
+    virtual serval::ScratchStats scratchStats (serval::Id task_name) const = 0;
+
+
+    /* ************************************* */
+    /* **** Diagnostics API             **** */
+    /* ************************************* */
+
+    /**
+     * @brief Copy the engine's performance counters
+     * The counters are always collected, reading them only costs the copy. See serval::debug::PerformanceOverlay.
+     *
+     * @param counters Overwritten with the current counters, existing capacity is reused
+     */
+    virtual void performanceCounters (serval::PerformanceCounters& counters) const = 0;
+
+    /**
+     * @brief Reset the maximum task times and stream traffic totals, eg to start investigating a spike
+     *
+     */
+    virtual void resetPerformanceCounters () = 0;
+
+
+    /* ************************************* */
+    /* **** Memory Tracking API         **** */
+    /* ************************************* */
+
+    /**
+     * @brief Get the memory used by an extension, or by one of its systems
+     * 
+     * @param extension_name The name of the extension
+     * @param system_name The name of the system, or 0 for the extension's total
+     * @return serval::MemoryUsage 
+     */
+    virtual serval::MemoryUsage memoryUsage (serval::Id extension_name, serval::Id system_name=0) const = 0;
+
+    /**
+     * @brief Get the memory used by every extension and system
+     * Pass the result to serval::format_memory_report() to export it as a text report
+     * 
+     * @param usage Cleared and filled with one entry per extension and system
+     */
+    virtual void memoryReport (std::vector<serval::MemoryUsage>& usage) const = 0;
+
 
     /* ************************************* */
     /* **** Resource Management API     **** */
     /* ************************************* */
 
+    /**
+     * @brief Get a typed view of all loaded resources of a type
+     * Prefer this over resolve() when looking up many handles, the view resolves handles without calling into the engine
+     * 
+     * @tparam Resource The type of resource to access
+     * @return serval::ResourceView<Resource> 
+     */
+    template <typename Resource>
+    serval::ResourceView<Resource> resources () const {
+        static_assert(serval::is_resource_v<Resource>, "Must be a resource type");
+        return serval::ResourceView<Resource>{get_resource_slots(Resource::ResourceTypeID)};
+    }
+
     /**
      * @brief Retrieve a resource from a handle
      * 
      * @tparam Resource The type of resource to retrieve
      * @param handle The handle to the resource
-     * @return Resource* A pointer to the resource
+     * @return Resource* A pointer to the resource, or nullptr if the handle is stale or invalid
      */
     template <typename Resource>
-    Resource* resolve (serval::Handle handle) {
-        static_assert(serval::is_resource_v<Resource>, "Must be a resource type");
-        return reinterpret_cast<Resource*>(get_resource_ptr(handle, Resource::ResourceTypeID));
+    Resource* resolve (serval::Handle handle) const {
+        return resources<Resource>().resolve(handle);
     }
 
 private:
@@ -554,7 +1184,14 @@ private:
     virtual void send_simple_command (serval::Id target_id, serval::Id command_id, serval::Id parameter) = 0;
     virtual void send_message (entt::entity target, serval::Id type, std::uint32_t metadata) const = 0;
     virtual void get_parameters_buffer (std::size_t size, serval::ParametersBuffer* info) const = 0;
-    virtual void* get_resource_ptr (serval::Handle handle, serval::Id resource_id) const = 0;
+    virtual serval::Handle request_asset (serval::Id asset_name, serval::Id asset_type, serval::Scalar priority, serval::Id stream) = 0;
+    virtual serval::Handle request_asset_at (serval::Id asset_name, serval::Id asset_type, const glm::vec3& position, serval::Id stream) = 0;
+    virtual const serval::ResourceSlots* get_resource_slots (serval::Id resource_id) const = 0;
+    virtual void mark_changed (entt::entity entity, entt::id_type component_type) = 0;
+    virtual void mark_all_changed (std::span<const entt::entity> entities, entt::id_type component_type) = 0;
+    virtual std::span<const entt::entity> changed_entities (entt::id_type component_type, serval::Version since) const = 0;
+    virtual bool owning_group (std::span<const entt::id_type> component_types) const = 0;
+    virtual const void* component_snapshots (entt::id_type component_type, serval::Scalar& alpha) const = 0;
     virtual entt::registry& registry () = 0;
 };
 
@@ -0,0 +1,228 @@
+#ifndef SERVAL_SDK__ARENA_HPP
+#define SERVAL_SDK__ARENA_HPP
+
+#include "types.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+
+namespace serval {
+    class ScratchArena;
+
+    template <typename T>
+    class ScratchSpan;
+
+    struct ScratchStats {
+        std::uint32_t allocations;  // Number of allocations
+        std::size_t bytes;          // Bytes allocated, including alignment padding
+        std::size_t high_water;     // Most bytes in use at once
+    };
+}
+
+/**
+ * @brief Linear allocator for temporary per-frame memory
+ *
+ * Each worker thread owns an arena, which the engine resets wholesale at the frame boundary. Allocation is a pointer bump;
+ * nothing is freed individually and no destructors run, so only trivially destructible types may be allocated.
+ * When an allocation doesn't fit, a new block is added; on reset the blocks are merged into a single block large enough
+ * for the whole frame, so steady state frames never allocate from the heap.
+ *
+ * The engine points the arena at the running task's MemoryCounter (see set_counter()), so scratch allocations count towards
+ * the owning system's allocation rate.
+ *
+ * In debug builds, memory is poisoned on reset and ScratchSpan checks that the arena has not been reset since the span
+ * was allocated.
+ */
+class serval::ScratchArena {
+public:
+    static constexpr std::uint8_t POISON = 0xcd;
+
+    explicit ScratchArena (std::size_t initial_size=256 * 1024) {
+        add_block(initial_size);
+    }
+    ScratchArena (const ScratchArena&) = delete;
+    ScratchArena& operator= (const ScratchArena&) = delete;
+
+    /**
+     * @brief Allocate uninitialised memory, valid until the end of the frame
+     *
+     * @param size
+     * @param alignment
+     * @return void*
+     */
+    void* allocate (std::size_t size, std::size_t alignment=alignof(std::max_align_t)) {
+        auto* block = &m_blocks.back();
+        auto offset = aligned_offset(*block, alignment);
+        if EXPECT_NOT_TAKEN(offset + size > block->size) {
+            block = &add_block(std::max(block->size * 2, size + alignment));
+            offset = aligned_offset(*block, alignment);
+        }
+        const auto padded = offset + size - block->used;
+        block->used = offset + size;
+        m_in_use += padded;
+        m_stats.bytes += padded;
+        m_stats.high_water = std::max(m_stats.high_water, m_in_use);
+        ++m_stats.allocations;
+        if (m_counter) {
+            m_counter->transient(padded);
+        }
+        return block->memory.get() + offset;
+    }
+
+    /**
+     * @brief Allocate a default-initialised array, valid until the end of the frame
+     *
+     * @tparam T A trivially destructible type
+     * @param count
+     * @return ScratchSpan<T>
+     */
+    template <typename T>
+    serval::ScratchSpan<T> allocate (std::size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "Scratch memory is released without running destructors");
+        auto* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_default_construct_n(data, count);
+        return {data, count, this};
+    }
+
+    /**
+     * @brief Release all allocations
+     * Called by the engine at the frame boundary
+     *
+     */
+    void reset () {
+        if (m_blocks.size() > 1) {
+            // Replace the chain with a single block that fits everything used this frame
+            std::size_t total = 0;
+            for (const auto& block : m_blocks) {
+                total += block.size;
+            }
+            m_blocks.clear();
+            add_block(total);
+        }
+#ifdef DEBUG
+        std::memset(m_blocks.back().memory.get(), POISON, m_blocks.back().used);
+#endif
+        m_blocks.back().used = 0;
+        m_in_use = 0;
+        ++m_epoch;
+    }
+
+    /**
+     * @brief Allocation statistics since the last call to reset_stats()
+     *
+     * @return const ScratchStats&
+     */
+    const serval::ScratchStats& stats () const {
+        return m_stats;
+    }
+
+    /**
+     * @brief Start collecting a new set of statistics, eg before running the next task on this worker
+     * The high water mark restarts from the bytes currently in use
+     *
+     */
+    void reset_stats () {
+        m_stats = {0, 0, m_in_use};
+    }
+
+    /**
+     * @brief Record subsequent allocations against a counter, or stop recording if nullptr
+     * Called by the engine before running each task on this worker
+     *
+     * @param counter
+     */
+    void set_counter (serval::MemoryCounter* counter) {
+        m_counter = counter;
+    }
+
+    /**
+     * @brief The number of times the arena has been reset
+     *
+     * @return std::uint32_t
+     */
+    std::uint32_t epoch () const {
+        return m_epoch;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        std::size_t size;
+        std::size_t used;
+    };
+
+    // Align the address rather than the offset, blocks are only aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__
+    static std::size_t aligned_offset (const Block& block, std::size_t alignment) {
+        const auto base = reinterpret_cast<std::uintptr_t>(block.memory.get());
+        return ((base + block.used + alignment - 1) & ~(std::uintptr_t(alignment) - 1)) - base;
+    }
+
+    Block& add_block (std::size_t size) {
+        m_blocks.push_back({std::unique_ptr<std::byte[]>{new std::byte[size]}, size, 0});
+        return m_blocks.back();
+    }
+
+    std::vector<Block> m_blocks;
+    std::size_t m_in_use = 0;
+    std::uint32_t m_epoch = 0;
+    serval::ScratchStats m_stats{};
+    serval::MemoryCounter* m_counter = nullptr;
+};
+
+/**
+ * @brief An array allocated from a ScratchArena
+ * In debug builds, accessing the span after the arena has been reset is an assertion failure
+ *
+ * @tparam T
+ */
+template <typename T>
+class serval::ScratchSpan {
+public:
+    ScratchSpan () = default;
+    ScratchSpan (T* data, std::size_t size, const serval::ScratchArena* arena) : m_data(data), m_size(size) {
+#ifdef DEBUG
+        m_arena = arena;
+        m_epoch = arena->epoch();
+#else
+        MAYBE_UNUSED(arena);
+#endif
+    }
+
+    T& operator[] (std::size_t index) const {
+        check();
+        ASSERT(index < m_size, "ScratchSpan index out of range");
+        return m_data[index];
+    }
+
+    T* data () const { check(); return m_data; }
+    T* begin () const { check(); return m_data; }
+    T* end () const { check(); return m_data + m_size; }
+    std::size_t size () const { return m_size; }
+    bool empty () const { return m_size == 0; }
+
+    operator std::span<T> () const {
+        check();
+        return {m_data, m_size};
+    }
+
+private:
+    void check () const {
+#ifdef DEBUG
+        ASSERT(m_arena == nullptr || m_arena->epoch() == m_epoch, "Scratch memory used after the arena was reset");
+#endif
+    }
+
+    T* m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef DEBUG
+    const serval::ScratchArena* m_arena = nullptr;
+    std::uint32_t m_epoch = 0;
+#endif
+};
+
+#endif
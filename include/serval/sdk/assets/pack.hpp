@@ -0,0 +1,363 @@
+#ifndef SERVAL_SDK__PACK_HPP_
+#define SERVAL_SDK__PACK_HPP_
+
+#include "../types.hpp"
+#include "text.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Read-only asset pack format
+ *
+ * A pack is designed to be memory-mapped and read in place. Everything is little-endian.
+ *
+ *     Header
+ *     std::uint32_t seeds[bucket_count]   Perfect hash displacement seeds
+ *     Entry entries[entry_count]          Indexed by the perfect hash of the asset's id
+ *     ...blobs...                         Page-aligned if at least a page in size, otherwise 16-byte aligned
+ *
+ * Looking up an asset hashes its id into a bucket, combines the bucket's seed with the id to get the entry slot and
+ * compares the stored id: one probe, no string compares and no filesystem access.
+ */
+namespace serval::pack {
+    static constexpr std::uint32_t MAGIC = 0x4b415053; // "SPAK"
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::uint32_t PAGE_SIZE = 4096;
+    static constexpr std::uint32_t SMALL_ALIGNMENT = 16;
+
+    enum class Compression : std::uint8_t {
+        None = 0,
+        LZ4  = 1,
+        Zstd = 2,
+    };
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t bucket_count;
+        std::uint64_t seeds_offset;
+        std::uint64_t entries_offset;
+    };
+    static_assert(sizeof(Header) == 32);
+
+    struct Entry {
+        serval::Id id;
+        serval::Id type;              // The AssetTypeId of the asset
+        std::uint64_t offset;         // From the start of the pack
+        std::uint64_t size;           // Stored (possibly compressed) size
+        std::uint64_t original_size;  // Size after decompression
+        Compression compression;
+        std::uint8_t reserved[3];
+        serval::Id text_id;           // The precomputed id of an interned Text asset, otherwise Id::INVALID
+    };
+    static_assert(sizeof(Entry) == 40);
+    static_assert(std::is_trivially_copyable_v<Entry>);
+
+    constexpr std::uint32_t mix (std::uint32_t value) {
+        value ^= value >> 16;
+        value *= 0x7feb352d;
+        value ^= value >> 15;
+        value *= 0x846ca68b;
+        value ^= value >> 16;
+        return value;
+    }
+
+    constexpr std::uint32_t bucket_of (serval::Id::Type id, std::uint32_t bucket_count) {
+        return mix(id) % bucket_count;
+    }
+
+    constexpr std::uint32_t slot_of (serval::Id::Type id, std::uint32_t seed, std::uint32_t entry_count) {
+        return mix(id ^ (seed * 0x9e3779b9u)) % entry_count;
+    }
+
+    class Pack;
+    class PackBuilder;
+}
+
+/**
+ * @brief A view over a memory-mapped pack
+ * The pack does not own the memory, it must stay mapped for as long as the Pack and any data read from it are in use
+ *
+ */
+class serval::pack::Pack {
+public:
+    Pack () = default;
+    explicit Pack (std::span<const std::byte> mapped) : m_data(mapped) {
+        if (mapped.size() < sizeof(Header)) {
+            return;
+        }
+        const auto* header = reinterpret_cast<const Header*>(mapped.data());
+        if (header->magic != MAGIC || header->version != VERSION || (header->entry_count > 0 && header->bucket_count == 0)) {
+            return;
+        }
+        if (!fits(header->seeds_offset, std::uint64_t(header->bucket_count) * sizeof(std::uint32_t), alignof(std::uint32_t)) ||
+            !fits(header->entries_offset, std::uint64_t(header->entry_count) * sizeof(Entry), alignof(Entry))) {
+            return;
+        }
+        // Check every blob up front, so that lookups and data() never have to
+        const auto* entries = reinterpret_cast<const Entry*>(mapped.data() + header->entries_offset);
+        for (std::uint32_t index = 0; index < header->entry_count; ++index) {
+            if (!fits(entries[index].offset, entries[index].size, 1)) {
+                return;
+            }
+        }
+        m_header = header;
+        m_seeds = reinterpret_cast<const std::uint32_t*>(mapped.data() + header->seeds_offset);
+        m_entries = entries;
+    }
+
+    /**
+     * @brief Check that the pack has a valid header and index, and that every asset lies within the mapped memory
+     * An invalid pack behaves as an empty one
+     *
+     * @return true
+     * @return false
+     */
+    bool valid () const {
+        return m_header != nullptr;
+    }
+
+    /**
+     * @brief The number of assets in the pack
+     *
+     * @return std::uint32_t
+     */
+    std::uint32_t size () const {
+        return m_header ? m_header->entry_count : 0;
+    }
+
+    /**
+     * @brief Look up an asset's index entry
+     *
+     * @param id The asset's id
+     * @return const Entry* The entry, or nullptr if the pack does not contain the asset
+     */
+    const Entry* find (serval::Id id) const {
+        if EXPECT_NOT_TAKEN(m_header == nullptr || m_header->entry_count == 0) {
+            return nullptr;
+        }
+        const auto seed = m_seeds[bucket_of(id, m_header->bucket_count)];
+        const auto* entry = m_entries + slot_of(id, seed, m_header->entry_count);
+        return entry->id == id ? entry : nullptr;
+    }
+
+    /**
+     * @brief The stored bytes of an asset, still compressed if entry.compression is not Compression::None
+     *
+     * @param entry
+     * @return std::span<const std::byte>
+     */
+    std::span<const std::byte> data (const Entry& entry) const {
+        return m_data.subspan(entry.offset, entry.size);
+    }
+
+    /**
+     * @brief Get a Text asset directly from the mapped pages
+     *
+     * @param id The asset's id
+     * @param out The text
+     * @return true The text was found
+     * @return false The asset does not exist, is not text, is compressed or is missing its NUL terminator
+     */
+    bool text (serval::Id id, serval::Text& out) const {
+        const auto* entry = find(id);
+        if (entry == nullptr || entry->type != serval::Text::AssetTypeId || entry->compression != Compression::None || entry->size == 0) {
+            return false;
+        }
+        // Text blobs are stored with a NUL terminator, which is not part of the text
+        const auto* chars = reinterpret_cast<const char*>(m_data.data() + entry->offset);
+        const auto size = std::size_t(entry->size - 1);
+        if (chars[size] != '\0') {
+            return false;
+        }
+        out = serval::Text{chars, size, entry->text_id};
+        return true;
+    }
+
+private:
+    // Whether [offset, offset + size) lies within the mapped memory and offset is aligned, without overflowing
+    bool fits (std::uint64_t offset, std::uint64_t size, std::uint64_t alignment) const {
+        return offset <= m_data.size() && size <= m_data.size() - offset && offset % alignment == 0;
+    }
+
+    std::span<const std::byte> m_data;
+    const Header* m_header = nullptr;
+    const std::uint32_t* m_seeds = nullptr;
+    const Entry* m_entries = nullptr;
+};
+
+/**
+ * @brief Builds a pack in memory, for use by asset tooling
+ *
+ */
+class serval::pack::PackBuilder {
+public:
+    /**
+     * @brief Add an asset
+     *
+     * @param id The asset's id
+     * @param type The AssetTypeId of the asset
+     * @param data The stored bytes
+     * @param compression How `data` was compressed
+     * @param original_size The size of the data after decompression (ignored if uncompressed)
+     * @return true The asset was added
+     * @return false An asset with the same id was already added
+     */
+    bool add (serval::Id id, serval::Id type, std::span<const std::byte> data, Compression compression=Compression::None, std::uint64_t original_size=0) {
+        if (!m_ids.insert(id).second) {
+            return false;
+        }
+        m_assets.push_back({id, type, {data.begin(), data.end()}, compression, compression == Compression::None ? data.size() : original_size, serval::Id::INVALID, NO_ASSET});
+        return true;
+    }
+
+    /**
+     * @brief Add a Text asset
+     * Texts of up to Text::INTERN_MAX_SIZE bytes are interned: their id is computed here and stored in the entry, and
+     * equal texts share one blob.
+     *
+     * @param id The asset's id
+     * @param text
+     * @return true The asset was added
+     * @return false An asset with the same id was already added
+     */
+    bool add_text (serval::Id id, std::string_view text) {
+        if (text.size() > serval::Text::INTERN_MAX_SIZE) {
+            std::vector<std::byte> bytes(text.size() + 1, std::byte{0});
+            std::memcpy(bytes.data(), text.data(), text.size());
+            return add(id, serval::Text::AssetTypeId, bytes);
+        }
+        if (!m_ids.insert(id).second) {
+            return false;
+        }
+        const serval::Id text_id = entt::hashed_string::value(text.data(), text.size());
+        const auto [interned, added] = m_interned.try_emplace(std::string{text}, std::uint32_t(m_assets.size()));
+        if (added) {
+            std::vector<std::byte> bytes(text.size() + 1, std::byte{0});
+            std::memcpy(bytes.data(), text.data(), text.size());
+            m_assets.push_back({id, serval::Text::AssetTypeId, std::move(bytes), Compression::None, text.size() + 1, text_id, NO_ASSET});
+        } else {
+            m_assets.push_back({id, serval::Text::AssetTypeId, {}, Compression::None, text.size() + 1, text_id, interned->second});
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lay out the pack and build its perfect hash index
+     *
+     * @return std::vector<std::byte> The complete pack file
+     */
+    std::vector<std::byte> build () const {
+        const auto entry_count = std::uint32_t(m_assets.size());
+        const auto bucket_count = std::max<std::uint32_t>(1, entry_count / 2);
+        std::vector<std::uint32_t> seeds(bucket_count, 0);
+        std::vector<std::uint32_t> slots(entry_count, NO_ASSET);
+        build_index(bucket_count, seeds, slots);
+
+        Header header{MAGIC, VERSION, entry_count, bucket_count, 0, 0};
+        header.seeds_offset = sizeof(Header);
+        header.entries_offset = align(header.seeds_offset + bucket_count * sizeof(std::uint32_t), alignof(Entry));
+        std::uint64_t end = header.entries_offset + std::uint64_t(entry_count) * sizeof(Entry);
+
+        // Lay out the blobs, then point every entry at its own blob or the one it shares
+        std::vector<std::uint64_t> offsets(entry_count, 0);
+        for (std::uint32_t slot = 0; slot < entry_count; ++slot) {
+            const auto& asset = m_assets[slots[slot]];
+            if (asset.shares == NO_ASSET) {
+                end = align(end, asset.data.size() >= PAGE_SIZE ? PAGE_SIZE : SMALL_ALIGNMENT);
+                offsets[slots[slot]] = end;
+                end += asset.data.size();
+            }
+        }
+        std::vector<Entry> entries(entry_count, Entry{});
+        for (std::uint32_t slot = 0; slot < entry_count; ++slot) {
+            const auto& asset = m_assets[slots[slot]];
+            const auto owner = asset.shares == NO_ASSET ? slots[slot] : asset.shares;
+            entries[slot] = Entry{asset.id, asset.type, offsets[owner], m_assets[owner].data.size(), asset.original_size, asset.compression, {}, asset.text_id};
+        }
+
+        std::vector<std::byte> pack(end, std::byte{0});
+        std::memcpy(pack.data(), &header, sizeof(Header));
+        std::memcpy(pack.data() + header.seeds_offset, seeds.data(), seeds.size() * sizeof(std::uint32_t));
+        std::memcpy(pack.data() + header.entries_offset, entries.data(), entries.size() * sizeof(Entry));
+        for (std::uint32_t slot = 0; slot < entry_count; ++slot) {
+            const auto& asset = m_assets[slots[slot]];
+            if (!asset.data.empty()) {
+                std::memcpy(pack.data() + entries[slot].offset, asset.data.data(), asset.data.size());
+            }
+        }
+        return pack;
+    }
+
+private:
+    static constexpr std::uint32_t NO_ASSET = ~std::uint32_t{0};
+
+    struct Asset {
+        serval::Id id;
+        serval::Id type;
+        std::vector<std::byte> data;
+        Compression compression;
+        std::uint64_t original_size;
+        serval::Id text_id;
+        std::uint32_t shares;  // The asset whose blob this one reuses, or NO_ASSET
+    };
+
+    static std::uint64_t align (std::uint64_t offset, std::uint64_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Hash and displace: place the largest buckets first, searching for a seed which maps all of a bucket's ids to free slots
+    void build_index (std::uint32_t bucket_count, std::vector<std::uint32_t>& seeds, std::vector<std::uint32_t>& slots) const {
+        const auto entry_count = std::uint32_t(m_assets.size());
+        std::vector<std::vector<std::uint32_t>> buckets(bucket_count);
+        for (std::uint32_t asset = 0; asset < entry_count; ++asset) {
+            buckets[bucket_of(m_assets[asset].id, bucket_count)].push_back(asset);
+        }
+        std::vector<std::uint32_t> order(bucket_count);
+        for (std::uint32_t bucket = 0; bucket < bucket_count; ++bucket) {
+            order[bucket] = bucket;
+        }
+        std::stable_sort(order.begin(), order.end(), [&buckets](std::uint32_t a, std::uint32_t b){ return buckets[a].size() > buckets[b].size(); });
+
+        std::vector<std::uint32_t> candidate;
+        for (const auto bucket : order) {
+            const auto& assets = buckets[bucket];
+            if (assets.empty()) {
+                break;
+            }
+            for (std::uint32_t seed = 0; ; ++seed) {
+                candidate.clear();
+                bool placed = true;
+                for (const auto asset : assets) {
+                    const auto slot = slot_of(m_assets[asset].id, seed, entry_count);
+                    if (slots[slot] != NO_ASSET || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                        placed = false;
+                        break;
+                    }
+                    candidate.push_back(slot);
+                }
+                if (placed) {
+                    for (std::size_t i = 0; i < assets.size(); ++i) {
+                        slots[candidate[i]] = assets[i];
+                    }
+                    seeds[bucket] = seed;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::vector<Asset> m_assets;
+    std::unordered_set<serval::Id::Type> m_ids;
+    std::unordered_map<std::string, std::uint32_t> m_interned;
+};
+
+#endif
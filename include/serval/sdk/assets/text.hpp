@@ -3,17 +3,61 @@
 
 #include "../types.hpp"
 
+#include <string>
+#include <string_view>
+
 namespace serval {
     class Text;
 }
 
+/**
+ * @brief A read-only string asset
+ * Text does not own its characters, they live in memory-mapped asset pack pages owned by the engine and are always NUL
+ * terminated. Accessors are inline and never copy, except for str().
+ * Strings of up to INTERN_MAX_SIZE bytes are interned when the pack is built: equal strings share storage and their
+ * hashed id is stored in the pack, so they can be compared and looked up by id() without hashing at load time.
+ *
+ */
 class serval::Text {
 public:
     ASSET("text");
-    virtual const char* c_str () = 0;
-    virtual std::size_t size () = 0;
+    static constexpr std::size_t INTERN_MAX_SIZE = 64;
+
+    Text () = default;
+    constexpr Text (const char* data, std::size_t size, serval::Id id) : m_data{data}, m_size{size}, m_id{id} {}
+
+    /**
+     * @brief The text, without copying
+     *
+     * @return std::string_view
+     */
+    std::string_view view () const {return {m_data, m_size};}
+    operator std::string_view () const {return view();}
+
+    const char* c_str () const {return m_data;}
+    std::size_t size () const {return m_size;}
+    bool empty () const {return m_size == 0;}
+
+    /**
+     * @brief The hashed id of the text if it was interned, otherwise serval::Id::INVALID
+     *
+     * @return serval::Id
+     */
+    serval::Id id () const {return m_id;}
+
+    /**
+     * @brief Copy the text into a new string
+     * Allocates, prefer view() in hot paths
+     *
+     * @return std::string
+     */
+    std::string str () const {return std::string{m_data, m_size};}
 
-    std::string str () {return std::string{c_str(), size()};}
+private:
+    const char* m_data = "";
+    std::size_t m_size = 0;
+    serval::Id m_id = serval::Id::INVALID;
 };
+static_assert(std::is_trivially_copyable_v<serval::Text>, "serval::Text must be trivially copyable");
 
-#endif
\ No newline at end of file
+#endif
@@ -52,6 +52,7 @@ namespace components::graphics {
         glm::vec3 color;
         glm::vec3 direction;
         serval::Scalar intensity;
+        serval::Scalar angle; // Half-angle of the cone, in radians
     };
 
 }
@@ -0,0 +1,186 @@
+#ifndef SERVAL_SDK__PERFORMANCE_OVERLAY_HPP
+#define SERVAL_SDK__PERFORMANCE_OVERLAY_HPP
+
+#include "../api.hpp"
+#include "../diagnostics.hpp"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace serval::debug {
+    class PerformanceOverlay;
+}
+
+/**
+ * @brief Dear ImGui window showing the engine's performance counters
+ * Call draw() from a task on the main thread each frame. While the overlay is hidden it does nothing, and while visible it
+ * only copies the counters every refresh interval, so it can be left compiled into production builds and toggled live.
+ *
+ * ```
+ * if (ImGui::IsKeyPressed(ImGuiKey_F3)) overlay.toggle();
+ * overlay.draw(runtime);
+ * ```
+ */
+class serval::debug::PerformanceOverlay {
+public:
+    explicit PerformanceOverlay (float refresh_seconds=0.25f, std::size_t slowest_tasks=20) : m_refresh_seconds(refresh_seconds), m_slowest_tasks(slowest_tasks) {}
+
+    void show (bool visible=true) { m_visible = visible; }
+    void toggle () { m_visible = !m_visible; }
+    bool visible () const { return m_visible; }
+
+    /**
+     * @brief Draw the overlay, if visible
+     *
+     * @param runtime
+     */
+    void draw (serval::Runtime& runtime) {
+        if (!m_visible) {
+            return;
+        }
+        m_elapsed += ImGui::GetIO().DeltaTime;
+        // While paused, keep showing the last snapshot, eg to inspect a spike
+        if (!m_refreshed || (!m_paused && m_elapsed >= m_refresh_seconds)) {
+            runtime.performanceCounters(m_counters);
+            std::sort(m_counters.tasks.begin(), m_counters.tasks.end(), [](const auto& a, const auto& b){ return a.max_ms > b.max_ms; });
+            std::sort(m_counters.commands.begin(), m_counters.commands.end(), [](const auto& a, const auto& b){ return a.per_second > b.per_second; });
+            std::sort(m_counters.messages.begin(), m_counters.messages.end(), [](const auto& a, const auto& b){ return a.per_second > b.per_second; });
+            m_elapsed = 0;
+            m_refreshed = true;
+        }
+
+        if (!ImGui::Begin("Performance", &m_visible)) {
+            ImGui::End();
+            return;
+        }
+        if (ImGui::Button("Reset counters")) {
+            runtime.resetPerformanceCounters();
+            m_refreshed = false;
+        }
+        ImGui::SameLine();
+        ImGui::Checkbox("Pause", &m_paused);
+
+        if (ImGui::CollapsingHeader("Schedulers", ImGuiTreeNodeFlags_DefaultOpen)) {
+            draw_schedulers();
+        }
+        if (ImGui::CollapsingHeader("Slowest tasks", ImGuiTreeNodeFlags_DefaultOpen)) {
+            draw_tasks();
+        }
+        if (ImGui::CollapsingHeader("Streams")) {
+            draw_streams();
+        }
+        if (ImGui::CollapsingHeader("Commands")) {
+            draw_rates("commands", m_counters.commands);
+        }
+        if (ImGui::CollapsingHeader("Messages")) {
+            draw_rates("messages", m_counters.messages);
+        }
+        if (ImGui::CollapsingHeader("Scratch arenas")) {
+            draw_arenas();
+        }
+        ImGui::End();
+    }
+
+private:
+    static constexpr ImGuiTableFlags TABLE_FLAGS = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_SizingStretchProp;
+
+    void draw_schedulers () {
+        char overlay[64];
+        for (const auto& scheduler : m_counters.schedulers) {
+            if (scheduler.frame_ms.empty()) {
+                continue;
+            }
+            const auto max = std::max_element(scheduler.frame_ms.begin(), scheduler.frame_ms.end());
+            std::snprintf(overlay, sizeof(overlay), "last %.2fms, max %.2fms", scheduler.frame_ms.back(), *max);
+            // Scale to the scheduler's interval where there is one, so that overruns stand out
+            const float scale = std::max(*max, scheduler.interval_ms);
+            ImGui::PlotHistogram(scheduler.name, scheduler.frame_ms.data(), int(scheduler.frame_ms.size()), 0, overlay, 0.0f, scale, ImVec2(0, 60));
+        }
+    }
+
+    void draw_tasks () {
+        if (!ImGui::BeginTable("tasks", 4, TABLE_FLAGS)) {
+            return;
+        }
+        ImGui::TableSetupColumn("Task");
+        ImGui::TableSetupColumn("Last (ms)");
+        ImGui::TableSetupColumn("Average (ms)");
+        ImGui::TableSetupColumn("Max (ms)");
+        ImGui::TableHeadersRow();
+        const auto count = std::min(m_slowest_tasks, m_counters.tasks.size());
+        for (std::size_t index = 0; index < count; ++index) {
+            const auto& task = m_counters.tasks[index];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(task.name);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", task.last_ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", task.average_ms);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", task.max_ms);
+        }
+        ImGui::EndTable();
+    }
+
+    void draw_streams () {
+        if (!ImGui::BeginTable("streams", 3, TABLE_FLAGS)) {
+            return;
+        }
+        ImGui::TableSetupColumn("Stream");
+        ImGui::TableSetupColumn("Records");
+        ImGui::TableSetupColumn("Bytes");
+        ImGui::TableHeadersRow();
+        for (const auto& stream : m_counters.streams) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(stream.name);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(stream.records));
+            ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(stream.bytes));
+        }
+        ImGui::EndTable();
+    }
+
+    void draw_rates (const char* id, const std::vector<serval::SendRate>& rates) {
+        if (!ImGui::BeginTable(id, 3, TABLE_FLAGS)) {
+            return;
+        }
+        ImGui::TableSetupColumn("Id");
+        ImGui::TableSetupColumn("Per second");
+        ImGui::TableSetupColumn("Total");
+        ImGui::TableHeadersRow();
+        for (const auto& rate : rates) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%08x", serval::Id::Type(rate.type));
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", rate.per_second);
+            ImGui::TableNextColumn(); ImGui::Text("%llu", static_cast<unsigned long long>(rate.total));
+        }
+        ImGui::EndTable();
+    }
+
+    void draw_arenas () {
+        if (!ImGui::BeginTable("arenas", 3, TABLE_FLAGS)) {
+            return;
+        }
+        ImGui::TableSetupColumn("Worker");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("High water (KiB)");
+        ImGui::TableHeadersRow();
+        for (std::size_t worker = 0; worker < m_counters.arenas.size(); ++worker) {
+            const auto& arena = m_counters.arenas[worker];
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::Text("%zu", worker);
+            ImGui::TableNextColumn(); ImGui::Text("%u", arena.allocations);
+            ImGui::TableNextColumn(); ImGui::Text("%.1f", double(arena.high_water) / 1024.0);
+        }
+        ImGui::EndTable();
+    }
+
+    serval::PerformanceCounters m_counters;
+    float m_refresh_seconds;
+    std::size_t m_slowest_tasks;
+    float m_elapsed = 0;
+    bool m_visible = false;
+    bool m_paused = false;
+    bool m_refreshed = false;
+};
+
+#endif
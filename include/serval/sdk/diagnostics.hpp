@@ -0,0 +1,71 @@
+#ifndef SERVAL_SDK__DIAGNOSTICS_HPP
+#define SERVAL_SDK__DIAGNOSTICS_HPP
+
+#include "types.hpp"
+#include "arena.hpp"
+
+#include <vector>
+
+namespace serval {
+    /**
+     * @brief Recent frame times of a scheduler
+     *
+     */
+    struct SchedulerTiming {
+        serval::Id scheduler;
+        const char* name;                 // Owned by the engine
+        float interval_ms;                // The scheduler's target interval, 0 if it runs every frame
+        std::vector<float> frame_ms;      // Most recent frames, oldest first
+    };
+
+    /**
+     * @brief Execution time of a task, measured on the worker which ran it
+     *
+     */
+    struct TaskTiming {
+        serval::Id scheduler;
+        serval::Id task;
+        const char* name;                 // Owned by the engine
+        float last_ms;
+        float average_ms;                 // Exponential moving average
+        float max_ms;                     // Since the counters were last reset
+    };
+
+    /**
+     * @brief Traffic through a stream since the counters were last reset
+     *
+     */
+    struct StreamTraffic {
+        serval::Id stream;
+        const char* name;                 // Owned by the engine
+        std::uint64_t records;
+        std::uint64_t bytes;
+    };
+
+    /**
+     * @brief How often a command or message type is sent
+     *
+     */
+    struct SendRate {
+        serval::Id type;
+        float per_second;                 // Averaged over the last second
+        std::uint64_t total;
+    };
+
+    /**
+     * @brief Snapshot of the engine's performance counters, see Runtime::performanceCounters()
+     * The engine updates the underlying counters with relaxed atomics as it runs; taking a snapshot copies them into these
+     * vectors, which are reused so that refreshing a snapshot does not allocate once they have grown.
+     *
+     */
+    struct PerformanceCounters {
+        std::vector<serval::SchedulerTiming> schedulers;
+        std::vector<serval::TaskTiming> tasks;
+        std::vector<serval::StreamTraffic> streams;
+        std::vector<serval::SendRate> commands;
+        std::vector<serval::SendRate> messages;
+        std::vector<serval::ScratchStats> arenas;  // One per worker thread, high water mark over the last frame
+    };
+}
+
+#endif
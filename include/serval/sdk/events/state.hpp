@@ -49,6 +49,7 @@ public:
 
     /**
      * @brief Event handler called when the game is being loaded
+     * For saves with delta segments, called once for the base snapshot and then once per delta in order (see Runtime::saveSegment())
      * Derived classes should also call the base method before their implementation
      * 
      * @param api A reference to the runtime API
@@ -74,6 +75,8 @@ public:
 
     /**
      * @brief Event handler called when the game is being saved
+     * Called at a frame boundary while no tasks are running. Saving continues in the background afterwards, so only copy
+     * state into the writer here and avoid expensive work.
      * Derived classes should also call the base method before their implementation
      * 
      * @param api A reference to the runtime API
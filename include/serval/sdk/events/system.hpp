@@ -52,7 +52,9 @@ public:
 
     /**
      * @brief Event handler called when the game is being loaded
-     * Called on both active and inactive systems
+     * Called on both active and inactive systems, concurrently with other systems' onLoad unless ordered with SystemSetup::loadAfter()
+     * `reader` only contains this system's section of the save
+     * For saves with delta segments, called once for the base snapshot and then once per delta in order (see Runtime::saveSegment())
      * 
      * @param api A reference to the runtime API
      * @param reader
@@ -61,7 +63,9 @@ public:
 
     /**
      * @brief Event handler called when the game is being saved
-     * Called on both active and inactive systems
+     * Called on both active and inactive systems, at a frame boundary while no tasks are running.
+     * Saving continues in the background afterwards, so only copy state into the writer here and avoid expensive work.
+     * Called concurrently with other systems' onSave, `writer` is private to this system and becomes its section of the save
      * 
      * @param api A reference to the runtime API
      * @param writer
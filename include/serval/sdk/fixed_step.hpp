@@ -0,0 +1,233 @@
+#ifndef SERVAL_SDK__FIXED_STEP_HPP
+#define SERVAL_SDK__FIXED_STEP_HPP
+
+#include "types.hpp"
+#include "components/core.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace serval {
+    class FixedStepClock;
+
+    template <typename Component>
+    class SnapshotBuffer;
+
+    /**
+     * @brief Blend between two fixed step snapshots of a component
+     *
+     * @param previous The value at the second to last fixed step
+     * @param current The value at the last fixed step
+     * @param alpha 0 for previous, 1 for current
+     */
+    inline components::core::Position interpolate (const components::core::Position& previous, const components::core::Position& current, serval::Scalar alpha) {
+        return {
+            previous.x + (current.x - previous.x) * alpha,
+            previous.y + (current.y - previous.y) * alpha,
+            previous.z + (current.z - previous.z) * alpha,
+        };
+    }
+
+    // Orientation is stored as per-axis angles in radians, which fixed steps only change by small amounts, so blend each
+    // axis the short way around: an angle wrapping from just under pi to just over -pi must not spin the long way back
+    inline components::core::Orientation interpolate (const components::core::Orientation& previous, const components::core::Orientation& current, serval::Scalar alpha) {
+        constexpr auto TAU = 2 * std::numbers::pi_v<serval::Scalar>;
+        return {
+            previous.x + std::remainder(current.x - previous.x, TAU) * alpha,
+            previous.y + std::remainder(current.y - previous.y, TAU) * alpha,
+            previous.z + std::remainder(current.z - previous.z, TAU) * alpha,
+        };
+    }
+}
+
+/**
+ * @brief Accumulator turning variable frame times into a whole number of fixed steps
+ *
+ * Each frame, advance() adds the frame's time and returns how many fixed steps to run, leaving the remainder for the
+ * next frame. alpha() is how far the remainder is into the next step, for blending the last two steps' snapshots.
+ *
+ * Catch-up is capped: if a frame ran long enough to need more than `max_steps` steps, only `max_steps` run and the
+ * rest of the time is dropped, so the simulation slows down rather than spiralling as each frame takes longer to
+ * catch up on the last.
+ */
+class serval::FixedStepClock {
+public:
+    /**
+     * @param interval_seconds The fixed step length, must be positive
+     * @param max_steps The most steps run in one frame
+     */
+    explicit FixedStepClock (float interval_seconds, std::uint32_t max_steps=5) : m_interval(interval_seconds), m_max_steps(max_steps) {
+        REQUIRE(interval_seconds > 0, "Fixed step interval must be positive");
+    }
+
+    /**
+     * @brief Add a frame's elapsed time
+     *
+     * @param frame_seconds The unscaled time since the last frame, negative or NaN times count as 0
+     * @return std::uint32_t The number of fixed steps to run this frame
+     */
+    std::uint32_t advance (float frame_seconds) {
+        // Negative and NaN frame times add nothing
+        if (frame_seconds > 0) {
+            m_accumulator += frame_seconds;
+        }
+        // Cap in floating point, so huge or infinite frame times never reach the integer conversion
+        const auto due = m_accumulator / m_interval;
+        std::uint32_t steps;
+        if (EXPECT_NOT_TAKEN(due >= float(m_max_steps) + 1)) {
+            m_dropped += m_accumulator - float(m_max_steps) * m_interval;
+            steps = m_max_steps;
+            m_accumulator = 0;
+        } else {
+            steps = std::uint32_t(due);
+            m_accumulator -= float(steps) * m_interval;
+        }
+        m_ticks += steps;
+        return steps;
+    }
+
+    /**
+     * @brief How far the time not yet simulated is into the next step
+     *
+     * @return serval::Scalar In [0, 1)
+     */
+    serval::Scalar alpha () const {
+        return std::clamp(m_accumulator / m_interval, 0.0f, 1.0f);
+    }
+
+    float interval () const {
+        return m_interval;
+    }
+
+    void setInterval (float interval_seconds) {
+        REQUIRE(interval_seconds > 0, "Fixed step interval must be positive");
+        m_interval = interval_seconds;
+    }
+
+    void setMaxSteps (std::uint32_t max_steps) {
+        m_max_steps = max_steps;
+    }
+
+    /**
+     * @brief The total number of fixed steps run
+     *
+     * @return std::uint64_t
+     */
+    std::uint64_t ticks () const {
+        return m_ticks;
+    }
+
+    /**
+     * @brief The total time dropped by the catch-up cap
+     *
+     * @return float Seconds
+     */
+    float dropped () const {
+        return m_dropped;
+    }
+
+    void reset () {
+        m_accumulator = 0;
+        m_dropped = 0;
+        m_ticks = 0;
+    }
+
+private:
+    float m_interval;
+    std::uint32_t m_max_steps;
+    float m_accumulator = 0;
+    float m_dropped = 0;
+    std::uint64_t m_ticks = 0;
+};
+
+/**
+ * @brief Double-buffered snapshots of a component, captured at each fixed step
+ *
+ * Slots are indexed by entity number, so capturing and reading are O(1) with no hashing. An entity first captured on
+ * the latest step has no previous value, so its previous value is set to its current one and it doesn't blend in from
+ * a stale position. Entities not captured on the latest step (destroyed, or the component was removed) read as absent.
+ * Slots remember the full entity, so a recycled entity number with a new version starts fresh rather than blending in
+ * from, or reading, the destroyed entity's snapshots.
+ *
+ * Written by the fixed step scheduler between its steps, read by any number of render-rate tasks.
+ *
+ * @tparam Component A component with a serval::interpolate() overload
+ */
+template <typename Component>
+class serval::SnapshotBuffer {
+public:
+    /**
+     * @brief Start capturing a new fixed step, the last step becomes the previous one
+     *
+     */
+    void begin () {
+        std::swap(m_previous, m_current);
+        ++m_tick;
+    }
+
+    /**
+     * @brief Record an entity's component value for the step started by begin()
+     *
+     * @param entity
+     * @param value
+     */
+    void capture (entt::entity entity, const Component& value) {
+        const auto index = std::size_t(entt::to_entity(entity));
+        if (EXPECT_NOT_TAKEN(index >= m_current.size())) {
+            const auto size = std::max(index + 1, m_current.size() * 2);
+            m_current.resize(size, Slot{{}, NEVER, entt::null});
+            m_previous.resize(size, Slot{{}, NEVER, entt::null});
+        }
+        m_current[index] = {value, m_tick, entity};
+        auto& previous = m_previous[index];
+        if (previous.tick != m_tick - 1 || previous.entity != entity) {
+            previous = {value, m_tick - 1, entity};
+        }
+    }
+
+    /**
+     * @brief Blend an entity's last two snapshots
+     *
+     * @param entity
+     * @param alpha The fixed step clock's alpha
+     * @param out Set to the blended value
+     * @return true The entity was captured on the latest step
+     * @return false The entity has no snapshot, or only an older version of it does, out is unchanged
+     */
+    bool interpolate (entt::entity entity, serval::Scalar alpha, Component& out) const {
+        const auto index = std::size_t(entt::to_entity(entity));
+        if (index >= m_current.size() || m_current[index].tick != m_tick || m_current[index].entity != entity) {
+            return false;
+        }
+        out = serval::interpolate(m_previous[index].value, m_current[index].value, alpha);
+        return true;
+    }
+
+    void clear () {
+        m_previous.clear();
+        m_current.clear();
+        m_tick = 0;
+    }
+
+private:
+    static constexpr std::uint64_t NEVER = std::numeric_limits<std::uint64_t>::max();
+
+    struct Slot {
+        Component value;
+        std::uint64_t tick;
+        entt::entity entity;
+    };
+
+    std::vector<Slot> m_previous;
+    std::vector<Slot> m_current;
+    std::uint64_t m_tick = 0;
+};
+
+#endif
@@ -0,0 +1,246 @@
+#ifndef SERVAL_SDK__GRAPHICS_DRAW_LIST_HPP
+#define SERVAL_SDK__GRAPHICS_DRAW_LIST_HPP
+
+#include "../types.hpp"
+#include "../components/graphics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace serval::graphics {
+    class DrawList;
+
+    // The textures bound by a components::graphics::Material
+    struct MaterialState {
+        serval::Handle albedo;
+        serval::Handle normal;
+        serval::Handle metalic;
+        serval::Handle roughness;
+        serval::Handle ambient_occlusion;
+
+        bool operator== (const MaterialState&) const = default;
+    };
+
+    // A single instanced draw call: draw `count` instances of `mesh` with `material`, taking instances [first, first + count)
+    struct DrawBatch {
+        serval::Handle mesh;
+        MaterialState material;
+        std::uint32_t first;
+        std::uint32_t count;
+        std::uint8_t layer;
+    };
+}
+
+/**
+ * @brief Builds a state-sorted list of instanced draw calls from Layer, Model and Material components
+ *
+ * Each draw is given a 64 bit sort key, packed from most to least significant as:
+ *     [ layer : 8 ][ material : 24 ][ mesh : 32 ]
+ * so that layers are drawn in order, and within a layer material (texture) changes are minimised before mesh changes.
+ * The material field is a hash of the material's texture handles, batches are split on the actual handles so a hash
+ * collision can only cost a state change, never produce an incorrect batch.
+ *
+ * Keys are sorted with an LSD radix sort. Passes over bytes which are equal for every key (eg a single layer) are skipped.
+ * The sort is split into partitions whose histogram and scatter steps are independent, so the caller can run them on the
+ * task pool by passing a parallel-for.
+ *
+ * The output is a flat array of DrawBatch commands plus the instance entities they reference, which renderer backends
+ * consume without touching the registry order.
+ */
+class serval::graphics::DrawList {
+public:
+    /**
+     * @brief Remove all draws and batches, keeping allocated memory
+     *
+     */
+    void clear () {
+        m_items.clear();
+        m_draws.clear();
+        m_batches.clear();
+        m_instances.clear();
+    }
+
+    /**
+     * @brief Reserve space for `count` draws
+     *
+     * @param count
+     */
+    void reserve (std::size_t count) {
+        m_items.reserve(count);
+        m_scratch.reserve(count);
+        m_draws.reserve(count);
+        m_instances.reserve(count);
+    }
+
+    /**
+     * @brief Add a draw
+     *
+     * @param entity The entity being drawn
+     * @param layer
+     * @param model
+     * @param material
+     */
+    void add (entt::entity entity, const components::graphics::Layer& layer, const components::graphics::Model& model, const components::graphics::Material& material) {
+        const MaterialState state{material.albedo, material.normal, material.metalic, material.roughness, material.ambient_occlusion};
+        m_items.push_back({make_key(layer.layer, state, model.mesh), std::uint32_t(m_draws.size())});
+        m_draws.push_back({entity, model.mesh, state});
+    }
+
+    /**
+     * @brief Sort the draws by key on the calling thread
+     *
+     */
+    void sort () {
+        sort([](std::size_t count, auto&& func) {
+            for (std::size_t index = 0; index < count; ++index) {
+                func(index);
+            }
+        }, 1);
+    }
+
+    /**
+     * @brief Sort the draws by key, distributing the work over `partitions` partitions
+     * `parallel_for(count, func)` must call `func(index)` for every index in [0, count) and return once all calls have completed.
+     * Calls for different indices may run concurrently.
+     *
+     * @tparam ParallelFor
+     * @param parallel_for
+     * @param partitions The maximum number of partitions (eg the number of workers)
+     */
+    template <typename ParallelFor>
+    void sort (ParallelFor&& parallel_for, std::size_t partitions) {
+        const auto count = m_items.size();
+        // Tiny partitions cost more in histogram merging than they gain
+        partitions = std::clamp<std::size_t>(count / MIN_PARTITION_SIZE, 1, std::max<std::size_t>(partitions, 1));
+        const auto partition_size = (count + partitions - 1) / partitions;
+        m_scratch.resize(count);
+        m_histograms.resize(partitions);
+
+        for (unsigned shift = 0; shift < 64; shift += 8) {
+            parallel_for(partitions, [this, shift, partition_size, count](std::size_t partition) {
+                auto& histogram = m_histograms[partition];
+                histogram.fill(0);
+                const auto end = std::min(count, (partition + 1) * partition_size);
+                for (auto index = partition * partition_size; index < end; ++index) {
+                    ++histogram[(m_items[index].key >> shift) & 0xff];
+                }
+            });
+
+            // Convert counts into scatter offsets, ordered by digit then partition so that the sort is stable
+            bool skip = false;
+            std::uint32_t offset = 0;
+            for (std::size_t digit = 0; digit < 256; ++digit) {
+                const auto digit_start = offset;
+                for (auto& histogram : m_histograms) {
+                    const auto digit_count = histogram[digit];
+                    histogram[digit] = offset;
+                    offset += digit_count;
+                }
+                skip |= (offset - digit_start) == count;
+            }
+            if (skip) {
+                // Every key has the same value for this byte, so the pass would not change the order
+                continue;
+            }
+
+            parallel_for(partitions, [this, shift, partition_size, count](std::size_t partition) {
+                auto& offsets = m_histograms[partition];
+                const auto end = std::min(count, (partition + 1) * partition_size);
+                for (auto index = partition * partition_size; index < end; ++index) {
+                    const auto& item = m_items[index];
+                    m_scratch[offsets[(item.key >> shift) & 0xff]++] = item;
+                }
+            });
+            std::swap(m_items, m_scratch);
+        }
+    }
+
+    /**
+     * @brief Merge the sorted draws into instanced batches
+     * Must be called after sort()
+     *
+     */
+    void build () {
+        m_batches.clear();
+        m_instances.clear();
+        for (const auto& item : m_items) {
+            const auto& draw = m_draws[item.draw];
+            const auto layer = std::uint8_t(item.key >> 56);
+            if (m_batches.empty() || m_batches.back().layer != layer || m_batches.back().mesh != draw.mesh || !(m_batches.back().material == draw.material)) {
+                m_batches.push_back({draw.mesh, draw.material, std::uint32_t(m_instances.size()), 0, layer});
+            }
+            ++m_batches.back().count;
+            m_instances.push_back(draw.entity);
+        }
+    }
+
+    /**
+     * @brief The instanced draw commands, in submission order
+     *
+     * @return std::span<const DrawBatch>
+     */
+    std::span<const DrawBatch> batches () const {
+        return m_batches;
+    }
+
+    /**
+     * @brief The entities drawn by the batches, indexed by DrawBatch::first
+     *
+     * @return std::span<const entt::entity>
+     */
+    std::span<const entt::entity> instances () const {
+        return m_instances;
+    }
+
+    /**
+     * @brief The number of draws added since the last clear()
+     *
+     * @return std::size_t
+     */
+    std::size_t size () const {
+        return m_items.size();
+    }
+
+    /**
+     * @brief Pack a sort key
+     *
+     * @param layer
+     * @param material
+     * @param mesh
+     * @return std::uint64_t
+     */
+    static std::uint64_t make_key (std::uint8_t layer, const MaterialState& material, serval::Handle mesh) {
+        // FNV-1a over the texture handles, folded to 24 bits
+        std::uint32_t hash = 2166136261u;
+        for (const auto handle : {material.albedo, material.normal, material.metalic, material.roughness, material.ambient_occlusion}) {
+            hash = (hash ^ std::uint32_t(handle)) * 16777619u;
+        }
+        const auto material_bits = (hash ^ (hash >> 24)) & 0xffffff;
+        return (std::uint64_t(layer) << 56) | (std::uint64_t(material_bits) << 32) | std::uint64_t(mesh);
+    }
+
+private:
+    static constexpr std::size_t MIN_PARTITION_SIZE = 4096;
+
+    struct Item {
+        std::uint64_t key;
+        std::uint32_t draw;
+    };
+
+    struct Draw {
+        entt::entity entity;
+        serval::Handle mesh;
+        MaterialState material;
+    };
+
+    std::vector<Item> m_items;
+    std::vector<Item> m_scratch;
+    std::vector<Draw> m_draws;
+    std::vector<std::array<std::uint32_t, 256>> m_histograms;
+    std::vector<DrawBatch> m_batches;
+    std::vector<entt::entity> m_instances;
+};
+
+#endif
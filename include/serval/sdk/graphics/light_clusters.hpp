@@ -0,0 +1,393 @@
+#ifndef SERVAL_SDK__GRAPHICS_LIGHT_CLUSTERS_HPP
+#define SERVAL_SDK__GRAPHICS_LIGHT_CLUSTERS_HPP
+
+#include "../types.hpp"
+#include "../components/core.hpp"
+#include "../components/graphics.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace serval::graphics {
+    class LightClusters;
+
+    // The camera parameters from which the cluster grid is built
+    struct ClusterCamera {
+        glm::vec3 position;
+        glm::vec3 forward;
+        glm::vec3 right;
+        glm::vec3 up;
+        serval::Scalar tan_half_fov_y;
+        serval::Scalar aspect;
+        serval::Scalar z_near;
+        serval::Scalar z_far;
+    };
+
+    // The lights affecting a cluster are indices()[offset, offset + count)
+    struct ClusterRange {
+        std::uint32_t offset;
+        std::uint32_t count;
+    };
+}
+
+/**
+ * @brief Bins point and spot lights into a view frustum grid of clusters
+ *
+ * The frustum is divided into X by Y screen tiles and Z depth slices, with slices spaced exponentially between the near and
+ * far planes. Lights are bounded by spheres (spot light cones by the sphere enclosing the cone), transformed into view space
+ * once, and assigned to the slices they overlap. Each slice is then binned independently, so slices can be processed in
+ * parallel by passing a parallel-for to build().
+ *
+ * Within a slice, lights are first filtered per tile row and then tested against each cluster's bounds. The tests run over
+ * structure-of-arrays buffers with branchless masks so that the compiler can vectorise them. Spot lights which pass the
+ * sphere test are refined with a cone-vs-cluster-sphere test.
+ *
+ * The output is renderer-agnostic: a ClusterRange per cluster, indexed by (z * Y + y) * X + x, and a flat array of light
+ * indices, where a light's index is the order in which it was added.
+ */
+class serval::graphics::LightClusters {
+public:
+    /**
+     * @param tiles_x Screen tiles across, must be non-zero
+     * @param tiles_y Screen tiles down, must be non-zero
+     * @param slices Depth slices, must be non-zero
+     */
+    LightClusters (std::uint32_t tiles_x=16, std::uint32_t tiles_y=9, std::uint32_t slices=24)
+        : m_tiles_x(tiles_x), m_tiles_y(tiles_y), m_slices(slices), m_slice_data(slices) {
+        REQUIRE(tiles_x > 0 && tiles_y > 0 && slices > 0, "Light cluster grid must have at least one tile and slice, got {}x{}x{}", tiles_x, tiles_y, slices);
+    }
+
+    /**
+     * @brief Remove all lights
+     *
+     */
+    void clear () {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+        m_radius.clear();
+        m_spot.clear();
+        m_spots.clear();
+    }
+
+    /**
+     * @brief Add a point light
+     *
+     * @param position The light's world-space position
+     * @param light
+     * @return std::uint32_t The index of the light
+     */
+    std::uint32_t add (const components::core::Position& position, const components::graphics::PointLight& light) {
+        return add_sphere(glm::vec3{position.x, position.y, position.z}, light.radius, NOT_A_SPOT);
+    }
+
+    /**
+     * @brief Add a spot light
+     *
+     * @param position The light's world-space position
+     * @param light
+     * @return std::uint32_t The index of the light
+     */
+    std::uint32_t add (const components::core::Position& position, const components::graphics::SpotLight& light) {
+        const glm::vec3 origin{position.x, position.y, position.z};
+        const auto cos_angle = std::cos(light.angle);
+        const auto sin_angle = std::sin(light.angle);
+        m_spots.push_back({origin, light.direction, light.range, cos_angle, sin_angle});
+        // Bounding sphere of the cone
+        if (light.angle > 0.785398f) {
+            return add_sphere(origin + light.direction * (cos_angle * light.range), sin_angle * light.range, std::uint32_t(m_spots.size() - 1));
+        } else {
+            const auto radius = light.range / (2.0f * cos_angle);
+            return add_sphere(origin + light.direction * radius, radius, std::uint32_t(m_spots.size() - 1));
+        }
+    }
+
+    /**
+     * @brief Bin the lights on the calling thread
+     *
+     * @param camera
+     */
+    void build (const ClusterCamera& camera) {
+        build(camera, [](std::size_t count, auto&& func) {
+            for (std::size_t index = 0; index < count; ++index) {
+                func(index);
+            }
+        });
+    }
+
+    /**
+     * @brief Bin the lights, processing depth slices in parallel
+     * `parallel_for(count, func)` must call `func(index)` for every index in [0, count) and return once all calls have completed.
+     * Calls for different indices may run concurrently.
+     *
+     * @tparam ParallelFor
+     * @param camera
+     * @param parallel_for
+     */
+    template <typename ParallelFor>
+    void build (const ClusterCamera& camera, ParallelFor&& parallel_for) {
+        m_camera = camera;
+        m_log_depth_ratio = std::log(camera.z_far / camera.z_near);
+        to_view_space();
+        parallel_for(m_slices, [this](std::size_t slice) {
+            bin_slice(std::uint32_t(slice));
+        });
+
+        // Stitch the per-slice results into the flat output buffers
+        const auto clusters_per_slice = m_tiles_x * m_tiles_y;
+        m_ranges.resize(std::size_t(clusters_per_slice) * m_slices);
+        std::size_t total = 0;
+        for (const auto& data : m_slice_data) {
+            total += data.indices.size();
+        }
+        m_indices.resize(total);
+        std::uint32_t base = 0;
+        for (std::uint32_t slice = 0; slice < m_slices; ++slice) {
+            const auto& data = m_slice_data[slice];
+            std::copy(data.indices.begin(), data.indices.end(), m_indices.begin() + base);
+            for (std::uint32_t cluster = 0; cluster < clusters_per_slice; ++cluster) {
+                const auto& range = data.ranges[cluster];
+                m_ranges[slice * clusters_per_slice + cluster] = {range.offset + base, range.count};
+            }
+            base += std::uint32_t(data.indices.size());
+        }
+    }
+
+    /**
+     * @brief The light range of every cluster, indexed by (z * Y + y) * X + x
+     *
+     * @return std::span<const ClusterRange>
+     */
+    std::span<const ClusterRange> clusters () const {
+        return m_ranges;
+    }
+
+    /**
+     * @brief The light indices referenced by the cluster ranges
+     *
+     * @return std::span<const std::uint32_t>
+     */
+    std::span<const std::uint32_t> indices () const {
+        return m_indices;
+    }
+
+    /**
+     * @brief The depth slice containing a view-space depth, as used when looking up clusters while shading
+     *
+     * @param depth
+     * @return std::uint32_t
+     */
+    std::uint32_t slice_of (serval::Scalar depth) const {
+        const auto slice = std::log(std::max(depth, m_camera.z_near) / m_camera.z_near) / m_log_depth_ratio * serval::Scalar(m_slices);
+        return std::min(std::uint32_t(slice), m_slices - 1);
+    }
+
+    /**
+     * @brief The view-space depth at which a slice begins
+     *
+     * @param slice
+     * @return serval::Scalar
+     */
+    serval::Scalar slice_depth (std::uint32_t slice) const {
+        return m_camera.z_near * std::exp(m_log_depth_ratio * serval::Scalar(slice) / serval::Scalar(m_slices));
+    }
+
+private:
+    static constexpr std::uint32_t NOT_A_SPOT = ~std::uint32_t{0};
+
+    struct Spot {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        serval::Scalar range;
+        serval::Scalar cos_angle;
+        serval::Scalar sin_angle;
+    };
+
+    // Structure-of-arrays light data gathered for one slice or row
+    struct Candidates {
+        std::vector<serval::Scalar> x, y, z, radius;
+        std::vector<std::uint32_t> light;
+
+        void clear () {
+            x.clear();
+            y.clear();
+            z.clear();
+            radius.clear();
+            light.clear();
+        }
+        void push (serval::Scalar cx, serval::Scalar cy, serval::Scalar cz, serval::Scalar r, std::uint32_t index) {
+            x.push_back(cx);
+            y.push_back(cy);
+            z.push_back(cz);
+            radius.push_back(r);
+            light.push_back(index);
+        }
+    };
+
+    struct SliceData {
+        Candidates slice;
+        Candidates row;
+        std::vector<std::uint8_t> mask;
+        std::vector<ClusterRange> ranges;
+        std::vector<std::uint32_t> indices;
+    };
+
+    std::uint32_t add_sphere (const glm::vec3& center, serval::Scalar radius, std::uint32_t spot) {
+        m_x.push_back(center.x);
+        m_y.push_back(center.y);
+        m_z.push_back(center.z);
+        m_radius.push_back(radius);
+        m_spot.push_back(spot);
+        return std::uint32_t(m_x.size() - 1);
+    }
+
+    void to_view_space () {
+        const auto count = m_x.size();
+        m_view_x.resize(count);
+        m_view_y.resize(count);
+        m_view_z.resize(count);
+        m_first_slice.resize(count);
+        m_last_slice.resize(count);
+        const auto& c = m_camera;
+        for (std::size_t i = 0; i < count; ++i) {
+            const glm::vec3 offset{m_x[i] - c.position.x, m_y[i] - c.position.y, m_z[i] - c.position.z};
+            m_view_x[i] = glm::dot(offset, c.right);
+            m_view_y[i] = glm::dot(offset, c.up);
+            m_view_z[i] = glm::dot(offset, c.forward);
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto min_z = m_view_z[i] - m_radius[i];
+            const auto max_z = m_view_z[i] + m_radius[i];
+            if (max_z < c.z_near || min_z > c.z_far) {
+                // Outside of the depth range, an empty slice range culls the light
+                m_first_slice[i] = 1;
+                m_last_slice[i] = 0;
+            } else {
+                m_first_slice[i] = slice_of(min_z);
+                m_last_slice[i] = slice_of(std::min(max_z, c.z_far));
+            }
+        }
+        m_view_spots.resize(m_spots.size());
+        for (std::size_t i = 0; i < m_spots.size(); ++i) {
+            const auto& spot = m_spots[i];
+            const auto offset = spot.origin - c.position;
+            m_view_spots[i] = spot;
+            m_view_spots[i].origin = {glm::dot(offset, c.right), glm::dot(offset, c.up), glm::dot(offset, c.forward)};
+            m_view_spots[i].direction = {glm::dot(spot.direction, c.right), glm::dot(spot.direction, c.up), glm::dot(spot.direction, c.forward)};
+        }
+    }
+
+    // Sphere vs box distance tests over the candidates, writing 1 into mask for each overlapping candidate
+    static void test_spheres (const Candidates& candidates, const glm::vec3& min, const glm::vec3& max, std::vector<std::uint8_t>& mask) {
+        const auto count = candidates.x.size();
+        mask.resize(count);
+        const auto* HEDLEY_RESTRICT x = candidates.x.data();
+        const auto* HEDLEY_RESTRICT y = candidates.y.data();
+        const auto* HEDLEY_RESTRICT z = candidates.z.data();
+        const auto* HEDLEY_RESTRICT r = candidates.radius.data();
+        auto* HEDLEY_RESTRICT out = mask.data();
+        for (std::size_t i = 0; i < count; ++i) {
+            const auto dx = std::max(std::max(min.x - x[i], x[i] - max.x), 0.0f);
+            const auto dy = std::max(std::max(min.y - y[i], y[i] - max.y), 0.0f);
+            const auto dz = std::max(std::max(min.z - z[i], z[i] - max.z), 0.0f);
+            out[i] = std::uint8_t(dx * dx + dy * dy + dz * dz <= r[i] * r[i]);
+        }
+    }
+
+    // Test a spot light's cone against a cluster's bounding sphere
+    bool test_cone (std::uint32_t light, const glm::vec3& center, serval::Scalar radius) const {
+        const auto& spot = m_view_spots[m_spot[light]];
+        const auto offset = center - spot.origin;
+        const auto length_squared = glm::dot(offset, offset);
+        const auto along = glm::dot(offset, spot.direction);
+        const auto across = std::sqrt(std::max(length_squared - along * along, 0.0f));
+        const auto distance = spot.cos_angle * across - along * spot.sin_angle;
+        return !(distance > radius || along > radius + spot.range || along < -radius);
+    }
+
+    void bin_slice (std::uint32_t slice) {
+        auto& data = m_slice_data[slice];
+        data.ranges.resize(std::size_t(m_tiles_x) * m_tiles_y);
+        data.indices.clear();
+        data.slice.clear();
+        for (std::uint32_t light = 0; light < m_x.size(); ++light) {
+            if (m_first_slice[light] <= slice && slice <= m_last_slice[light]) {
+                data.slice.push(m_view_x[light], m_view_y[light], m_view_z[light], m_radius[light], light);
+            }
+        }
+
+        const auto z_near = slice_depth(slice);
+        const auto z_far = slice_depth(slice + 1);
+        const auto tan_y = m_camera.tan_half_fov_y;
+        const auto tan_x = tan_y * m_camera.aspect;
+        // The view-space extent of a column or row of tiles between the slice's depths
+        const auto extent = [z_near, z_far](serval::Scalar tan_half, std::uint32_t tile, std::uint32_t tiles, serval::Scalar& lo, serval::Scalar& hi) {
+            const auto slope_lo = -tan_half + 2.0f * tan_half * serval::Scalar(tile) / serval::Scalar(tiles);
+            const auto slope_hi = -tan_half + 2.0f * tan_half * serval::Scalar(tile + 1) / serval::Scalar(tiles);
+            lo = std::min(slope_lo * z_near, slope_lo * z_far);
+            hi = std::max(slope_hi * z_near, slope_hi * z_far);
+        };
+
+        for (std::uint32_t y = 0; y < m_tiles_y; ++y) {
+            serval::Scalar min_y, max_y;
+            extent(tan_y, y, m_tiles_y, min_y, max_y);
+            const auto min_x = -tan_x * z_far;
+            const auto max_x = tan_x * z_far;
+            // Coarse test against the whole row before testing individual clusters
+            test_spheres(data.slice, {min_x, min_y, z_near}, {max_x, max_y, z_far}, data.mask);
+            data.row.clear();
+            for (std::size_t i = 0; i < data.mask.size(); ++i) {
+                if (data.mask[i]) {
+                    data.row.push(data.slice.x[i], data.slice.y[i], data.slice.z[i], data.slice.radius[i], data.slice.light[i]);
+                }
+            }
+
+            for (std::uint32_t x = 0; x < m_tiles_x; ++x) {
+                glm::vec3 min{0.0f, min_y, z_near};
+                glm::vec3 max{0.0f, max_y, z_far};
+                extent(tan_x, x, m_tiles_x, min.x, max.x);
+                auto& range = data.ranges[y * m_tiles_x + x];
+                range.offset = std::uint32_t(data.indices.size());
+                if (!data.row.x.empty()) {
+                    test_spheres(data.row, min, max, data.mask);
+                    const auto center = (min + max) * 0.5f;
+                    const auto radius = glm::length(max - center);
+                    for (std::size_t i = 0; i < data.mask.size(); ++i) {
+                        const auto light = data.row.light[i];
+                        if (data.mask[i] && (m_spot[light] == NOT_A_SPOT || test_cone(light, center, radius))) {
+                            data.indices.push_back(light);
+                        }
+                    }
+                }
+                range.count = std::uint32_t(data.indices.size()) - range.offset;
+            }
+        }
+    }
+
+    std::uint32_t m_tiles_x;
+    std::uint32_t m_tiles_y;
+    std::uint32_t m_slices;
+    ClusterCamera m_camera{};
+    serval::Scalar m_log_depth_ratio = 1.0f;
+
+    // World-space bounding spheres, by light index
+    std::vector<serval::Scalar> m_x, m_y, m_z, m_radius;
+    std::vector<std::uint32_t> m_spot;
+    std::vector<Spot> m_spots;
+
+    // View-space data, rebuilt by build()
+    std::vector<serval::Scalar> m_view_x, m_view_y, m_view_z;
+    std::vector<std::uint32_t> m_first_slice, m_last_slice;
+    std::vector<Spot> m_view_spots;
+
+    std::vector<SliceData> m_slice_data;
+    std::vector<ClusterRange> m_ranges;
+    std::vector<std::uint32_t> m_indices;
+};
+
+#endif
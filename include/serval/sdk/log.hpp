@@ -0,0 +1,343 @@
+#ifndef SERVAL_SDK__LOG_HPP
+#define SERVAL_SDK__LOG_HPP
+
+#include "types.hpp"
+#include "memory.hpp"
+
+#include <spdlog/spdlog.h>
+#if defined(SPDLOG_FMT_EXTERNAL)
+#include <fmt/args.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Asynchronous binary logging
+ *
+ * A log call site records a pointer to its static CallSite (which holds the compile-time format string) and its raw
+ * arguments into a lock-free ring owned by the calling thread. A background thread drains the rings, formats the records
+ * and passes them on to spdlog, so the calling worker never formats or touches a sink.
+ *
+ * Arguments must be arithmetic, enums, pointers or serval::Id. Strings are not supported, since the record may be formatted
+ * after the caller's string has gone; use spdlog directly for those (off the hot path).
+ *
+ * Each call site may be rate-limited: while suppressed, calls cost a clock read and a relaxed load and compare, and the
+ * number of suppressed calls is reported with the next message that gets through.
+ */
+namespace serval::log {
+    static constexpr std::size_t MAX_ARGS = 5;
+    static constexpr std::uint32_t RING_CAPACITY = 1024; // Records per thread, must be a power of two
+    static constexpr std::uint32_t DEFAULT_INTERVAL_MS = 1000;
+
+    enum class ArgType : std::uint8_t {
+        Int,
+        UInt,
+        Float,
+        Bool,
+        Char,
+        Pointer,
+    };
+
+    struct CallSite {
+        const char* format;
+        spdlog::level::level_enum level;
+        std::uint32_t interval_ms;                     // Minimum time between messages, 0 to never rate-limit
+        std::atomic<std::uint64_t> next_allowed_ms = 0;
+        std::atomic<std::uint32_t> suppressed = 0;
+    };
+
+    struct Record {
+        const CallSite* site;
+        std::uint32_t suppressed;
+        std::uint8_t count;
+        ArgType types[MAX_ARGS];
+        std::uint64_t args[MAX_ARGS];
+    };
+    static_assert(sizeof(Record) == 64, "Records should fill one cache line");
+
+    class Ring;
+    class Backend;
+
+    void set_backend (Backend* backend);
+    Backend* backend ();
+    std::string format (const Record& record);
+
+    template <typename... Args>
+    void write (CallSite& site, const Args&... args);
+}
+
+/**
+ * @brief Single producer, single consumer ring of records, written by one thread and drained by the Backend
+ *
+ */
+class serval::log::Ring {
+public:
+    bool push (const Record& record) {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if EXPECT_NOT_TAKEN(head - m_cached_tail == RING_CAPACITY) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cached_tail == RING_CAPACITY) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_records[head & (RING_CAPACITY - 1)] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Fn>
+    void drain (Fn&& fn) {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        const auto head = m_head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            fn(m_records[tail & (RING_CAPACITY - 1)]);
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    std::uint64_t take_dropped () {
+        return m_dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+private:
+    alignas(serval::CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_head = 0;
+    std::uint32_t m_cached_tail = 0;
+    alignas(serval::CACHE_LINE_SIZE) std::atomic<std::uint32_t> m_tail = 0;
+    std::atomic<std::uint64_t> m_dropped = 0;
+    Record m_records[RING_CAPACITY];
+};
+
+/**
+ * @brief Owns the per-thread rings and the thread which formats them into spdlog
+ * Created by the engine and handed to extensions through ExtensionInit::log_backend.
+ *
+ */
+class serval::log::Backend {
+public:
+    explicit Backend (std::shared_ptr<spdlog::logger> logger, std::chrono::milliseconds interval=std::chrono::milliseconds{2})
+        : m_logger(std::move(logger)), m_interval(interval), m_epoch(std::chrono::steady_clock::now()) {}
+    Backend (const Backend&) = delete;
+    Backend& operator= (const Backend&) = delete;
+
+    ~Backend () {
+        stop();
+    }
+
+    /**
+     * @brief Start the background thread
+     *
+     */
+    void start () {
+        if (m_running.exchange(true)) {
+            return;
+        }
+        m_thread = std::thread([this](){
+            while (m_running.load(std::memory_order_relaxed)) {
+                drain();
+                std::this_thread::sleep_for(m_interval);
+            }
+            drain();
+        });
+    }
+
+    /**
+     * @brief Stop the background thread, after formatting any remaining records
+     *
+     */
+    void stop () {
+        if (m_running.exchange(false) && m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    /**
+     * @brief Format and sink all pending records
+     * Called by the background thread, or directly eg before aborting
+     *
+     */
+    void drain () {
+        std::scoped_lock lock{m_mutex};
+        for (auto& [thread, ring] : m_rings) {
+            ring->drain([this](const Record& record){
+                m_logger->log(record.site->level, format(record));
+            });
+            if (const auto dropped = ring->take_dropped(); dropped) {
+                m_logger->warn("Log ring full, {} messages dropped", dropped);
+            }
+        }
+        m_logger->flush();
+    }
+
+    /**
+     * @brief The calling thread's ring, created on first use
+     *
+     * @return Ring&
+     */
+    Ring& ring () {
+        const auto id = std::this_thread::get_id();
+        std::scoped_lock lock{m_mutex};
+        for (auto& [thread, ring] : m_rings) {
+            if (thread == id) {
+                return *ring;
+            }
+        }
+        m_rings.emplace_back(id, std::make_unique<Ring>());
+        return *m_rings.back().second;
+    }
+
+    /**
+     * @brief Milliseconds since the backend was created
+     * Read from the clock on every rate-limited call, so suppression doesn't depend on the background thread running.
+     * 64 bits, so it never wraps.
+     *
+     * @return std::uint64_t
+     */
+    std::uint64_t now_ms () const {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+    }
+
+private:
+    std::shared_ptr<spdlog::logger> m_logger;
+    std::chrono::milliseconds m_interval;
+    std::chrono::steady_clock::time_point m_epoch;
+    std::atomic<bool> m_running = false;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<Ring>>> m_rings;
+};
+
+namespace serval::log::detail {
+    inline Backend*& backend_ptr () {
+        static Backend* backend = nullptr;
+        return backend;
+    }
+
+    // Cached per thread, rings outlive hot reloads since they are owned by the backend
+    inline thread_local Ring* t_ring = nullptr;
+    inline thread_local Backend* t_ring_owner = nullptr;
+
+    template <typename T>
+    void encode (Record& record, const T& arg) {
+        auto& type = record.types[record.count];
+        auto& value = record.args[record.count++];
+        if constexpr (std::is_same_v<T, bool>) {
+            type = ArgType::Bool;
+            value = arg;
+        } else if constexpr (std::is_same_v<T, char>) {
+            type = ArgType::Char;
+            value = std::uint64_t(arg);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            type = ArgType::Float;
+            const double number = arg;
+            std::memcpy(&value, &number, sizeof(double));
+        } else if constexpr (std::is_enum_v<T>) {
+            type = ArgType::Int;
+            value = std::uint64_t(std::int64_t(arg));
+        } else if constexpr (std::is_same_v<T, serval::Id>) {
+            type = ArgType::UInt;
+            value = serval::Id::Type(arg);
+        } else if constexpr (std::is_pointer_v<T>) {
+            static_assert(!std::is_same_v<std::remove_cv_t<std::remove_pointer_t<T>>, char>, "String arguments are not supported by the binary log");
+            type = ArgType::Pointer;
+            value = reinterpret_cast<std::uintptr_t>(arg);
+        } else if constexpr (std::is_signed_v<T>) {
+            type = ArgType::Int;
+            value = std::uint64_t(std::int64_t(arg));
+        } else {
+            static_assert(std::is_unsigned_v<T>, "Binary log arguments must be arithmetic, enums, pointers or serval::Id");
+            type = ArgType::UInt;
+            value = arg;
+        }
+    }
+}
+
+inline void serval::log::set_backend (Backend* backend) {
+    detail::backend_ptr() = backend;
+}
+
+inline serval::log::Backend* serval::log::backend () {
+    return detail::backend_ptr();
+}
+
+/**
+ * @brief Format a record's message
+ *
+ * @param record
+ * @return std::string
+ */
+inline std::string serval::log::format (const Record& record) {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    for (std::uint8_t index = 0; index < record.count; ++index) {
+        const auto value = record.args[index];
+        switch (record.types[index]) {
+            case ArgType::Int: store.push_back(std::int64_t(value)); break;
+            case ArgType::UInt: store.push_back(value); break;
+            case ArgType::Float: {
+                double number;
+                std::memcpy(&number, &value, sizeof(double));
+                store.push_back(number);
+                break;
+            }
+            case ArgType::Bool: store.push_back(value != 0); break;
+            case ArgType::Char: store.push_back(char(value)); break;
+            case ArgType::Pointer: store.push_back(reinterpret_cast<const void*>(std::uintptr_t(value))); break;
+        }
+    }
+    std::string message;
+    try {
+        message = fmt::vformat(record.site->format, store);
+    } catch (const fmt::format_error&) {
+        message = record.site->format;
+    }
+    if (record.suppressed) {
+        message += fmt::format(" ({} similar messages suppressed)", record.suppressed);
+    }
+    return message;
+}
+
+/**
+ * @brief Record a message
+ * Use the LOG_* macros, which provide the static CallSite
+ *
+ * @param site
+ * @param args
+ */
+template <typename... Args>
+void serval::log::write (CallSite& site, const Args&... args) {
+    static_assert(sizeof...(Args) <= MAX_ARGS, "Too many binary log arguments");
+    auto* backend = detail::backend_ptr();
+    // Rate limiting uses the backend's clock, so messages logged before a backend is installed are never suppressed
+    if (site.interval_ms && backend) {
+        const auto now = backend->now_ms();
+        auto next = site.next_allowed_ms.load(std::memory_order_relaxed);
+        if (now < next || !site.next_allowed_ms.compare_exchange_strong(next, now + site.interval_ms, std::memory_order_relaxed)) {
+            site.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    Record record{&site, site.suppressed.exchange(0, std::memory_order_relaxed), 0, {}, {}};
+    (detail::encode(record, args), ...);
+    if EXPECT_NOT_TAKEN(backend == nullptr) {
+        // No backend installed yet (eg during startup), log synchronously
+        spdlog::default_logger_raw()->log(site.level, format(record));
+        return;
+    }
+    if EXPECT_NOT_TAKEN(detail::t_ring_owner != backend) {
+        detail::t_ring = &backend->ring();
+        detail::t_ring_owner = backend;
+    }
+    detail::t_ring->push(record);
+}
+
+#endif
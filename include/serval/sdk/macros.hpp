@@ -3,6 +3,9 @@
 
 #include <hedley.h>
 
+#include <cstdio>
+#include <cstdlib>
+
 // Compiler optimizations
 
 #define EXPECT_TAKEN(cond) (HEDLEY_LIKELY(cond))
@@ -18,27 +21,45 @@
 // Silence warnings
 #define MAYBE_UNUSED(var) (void)var
 
+// Logging, recorded in binary form and formatted on a background thread (see log.hpp)
+// Arguments must be arithmetic, enums, pointers or serval::Id. Warnings and errors are rate-limited per call site.
+
+#define serval__LOG_(level, interval_ms, fmtstr, ...) {static serval::log::CallSite serval__log_site{fmtstr, level, interval_ms}; serval::log::write(serval__log_site __VA_OPT__(,) __VA_ARGS__);}
+#define LOG_INFO(fmtstr, ...) serval__LOG_(spdlog::level::info, 0, fmtstr __VA_OPT__(,) __VA_ARGS__)
+#define LOG_WARN(fmtstr, ...) serval__LOG_(spdlog::level::warn, serval::log::DEFAULT_INTERVAL_MS, __FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " " fmtstr __VA_OPT__(,) __VA_ARGS__)
+#define LOG_ERROR(fmtstr, ...) serval__LOG_(spdlog::level::err, serval::log::DEFAULT_INTERVAL_MS, __FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " " fmtstr __VA_OPT__(,) __VA_ARGS__)
+
 // Constraints
 
 // TODO: _REQUIRE_IMPL to call error function instead of throwing
 
 #define _REQUIRE_IMPL(fmtstr, ...) throw std::logic_error(fmt::format(fmtstr __VA_OPT__(,) __VA_ARGS__));
-#define _ASSERT_IMPL(fmtstr, ...) {SPDLOG_ERROR(fmtstr __VA_OPT__(,) __VA_ARGS__); std::abort(-1);}
+#define _ASSERT_IMPL(message) serval::detail::assert_failed(message);
+
+namespace serval::detail {
+    // Written straight to stderr rather than through the log backend, whose thread won't get to drain it before the abort
+    [[noreturn]] HEDLEY_NEVER_INLINE inline void assert_failed (const char* message) {
+        std::fputs(message, stderr);
+        std::fputc('\n', stderr);
+        std::fflush(stderr);
+        std::abort();
+    }
+}
 
 #define REQUIRE(condition, ...) {if EXPECT_NOT_TAKEN(!(condition)) {_REQUIRE_IMPL(__FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " Requirement not met (" #condition "): " __VA_ARGS__)}}
 #define FAIL(fmt, ...) _REQUIRE_IMPL((__FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " " fmt)  __VA_OPT__(,) __VA_ARGS__)
 
 #if SPDLOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_WARN
-#define SOFT_REQUIRE(condition, ...) {if EXPECT_NOT_TAKEN(!(condition)){SPDLOG_WARN(__FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " Requirement not met (" #condition "): " __VA_ARGS__)}}
+#define SOFT_REQUIRE(condition, ...) {if EXPECT_NOT_TAKEN(!(condition)){serval__LOG_(spdlog::level::warn, serval::log::DEFAULT_INTERVAL_MS, __FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " Requirement not met (" #condition "): " __VA_ARGS__)}}
 #else
 // Don't even bother checking if we can't warn
 #define SOFT_REQUIRE(condition, ...)
 #endif
 
 #ifdef DEBUG
-#define ASSERT(condition, ...) {if EXPECT_NOT_TAKEN(!(condition)){_ASSERT_IMPL(__FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " Assertion failure (" #condition "): " __VA_ARGS__)}}
+#define ASSERT(condition, message) {if EXPECT_NOT_TAKEN(!(condition)){_ASSERT_IMPL(__FILE__ ":" HEDLEY_STRINGIFY(__LINE__) " Assertion failure (" #condition "): " message)}}
 #else
-#define ASSERT(condition, ...) (void)0
+#define ASSERT(condition, message) (void)0
 #endif
 
 // Declaring types with static names and/or IDs
@@ -47,7 +68,8 @@
 #define serval__NAME_(type, name) static constexpr char* HEDLEY_CONCAT(type, Name) = name
 #define serval__TYPE_ID_(type, name) serval__ID_(HEDLEY_CONCAT(type, Type), name)
 
-#define ASSET(name) serval__TYPE_ID_(Asset, name)
+// Assets are resources once resident, in a resource table of the same type id, so resolve<Asset>() finds them
+#define ASSET(name) serval__TYPE_ID_(Asset, name); static constexpr serval::Id ResourceTypeID = AssetTypeId
 #define COMPONENT(name) serval__NAME_(Component, name); serval__TYPE_ID_(Component, name)
 #define SYSTEM(name) serval__NAME_(System, name); serval__ID_(System, name)
 
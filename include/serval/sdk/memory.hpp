@@ -0,0 +1,205 @@
+#ifndef SERVAL_SDK__MEMORY_HPP
+#define SERVAL_SDK__MEMORY_HPP
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace serval {
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    /**
+     * @brief The owner of tracked allocations
+     *
+     */
+    struct MemoryTag {
+        serval::Id extension;
+        serval::Id system;      // 0 for allocations made by the extension outside of any system
+    };
+
+    /**
+     * @brief Snapshot of the memory used by an extension or system
+     *
+     */
+    struct MemoryUsage {
+        serval::MemoryTag tag;
+        const char* extension_name;    // Owned by the engine, nullptr if the id has no registered name
+        const char* system_name;       // Owned by the engine, nullptr for the extension's total or an unnamed id
+        std::int64_t live_bytes;       // Currently allocated
+        std::int64_t peak_bytes;       // Most bytes allocated at once
+        std::uint64_t allocations;     // Total number of allocations, including scratch allocations
+        float bytes_per_second;        // Allocation rate, averaged by the engine over the last second
+    };
+
+    class MemoryCounter;
+
+    template <typename T>
+    class TrackedAllocator;
+
+    inline std::string format_memory_report (std::span<const serval::MemoryUsage> usage);
+}
+
+/**
+ * @brief Allocation counters for one owner (see Init::memoryCounter())
+ * SDK allocators which are given a counter record every allocation against it. Updates are relaxed atomic adds, cheap enough
+ * to stay enabled in release builds. Each counter sits on its own cache line so that systems running on different workers
+ * do not contend.
+ *
+ */
+class alignas(serval::CACHE_LINE_SIZE) serval::MemoryCounter {
+public:
+    MemoryCounter () = default;
+    MemoryCounter (const MemoryCounter&) = delete;
+    MemoryCounter& operator= (const MemoryCounter&) = delete;
+
+    /**
+     * @brief Record memory which stays allocated until freed()
+     *
+     * @param bytes
+     */
+    void allocated (std::size_t bytes) {
+        const auto live = m_live.fetch_add(std::int64_t(bytes), std::memory_order_relaxed) + std::int64_t(bytes);
+        m_allocated.fetch_add(bytes, std::memory_order_relaxed);
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        auto peak = m_peak.load(std::memory_order_relaxed);
+        while (live > peak && !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * @brief Record memory returned by a previous allocated()
+     *
+     * @param bytes
+     */
+    void freed (std::size_t bytes) {
+        m_live.fetch_sub(std::int64_t(bytes), std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Record memory which is released wholesale by its allocator, eg scratch memory
+     * Counts towards the allocation count and rate, but not the live bytes
+     *
+     * @param bytes
+     */
+    void transient (std::size_t bytes) {
+        m_allocated.fetch_add(bytes, std::memory_order_relaxed);
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::int64_t live_bytes () const { return m_live.load(std::memory_order_relaxed); }
+    std::int64_t peak_bytes () const { return m_peak.load(std::memory_order_relaxed); }
+    std::uint64_t allocations () const { return m_allocations.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Total bytes ever allocated, sampled by the engine to compute the allocation rate
+     *
+     * @return std::uint64_t
+     */
+    std::uint64_t allocated_bytes () const { return m_allocated.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> m_live = 0;
+    std::atomic<std::int64_t> m_peak = 0;
+    std::atomic<std::uint64_t> m_allocated = 0;
+    std::atomic<std::uint64_t> m_allocations = 0;
+};
+
+/**
+ * @brief Standard allocator which records allocations against a MemoryCounter
+ * `std::vector<Foo, serval::TrackedAllocator<Foo>> foos{serval::TrackedAllocator<Foo>{counter}};`
+ *
+ * @tparam T
+ */
+template <typename T>
+class serval::TrackedAllocator {
+public:
+    using value_type = T;
+
+    explicit TrackedAllocator (serval::MemoryCounter& counter) : m_counter(&counter) {}
+    template <typename U>
+    TrackedAllocator (const TrackedAllocator<U>& other) : m_counter(other.counter()) {}
+
+    T* allocate (std::size_t count) {
+        m_counter->allocated(count * sizeof(T));
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{alignof(T)}));
+    }
+
+    void deallocate (T* memory, std::size_t count) {
+        m_counter->freed(count * sizeof(T));
+        ::operator delete(memory, std::align_val_t{alignof(T)});
+    }
+
+    serval::MemoryCounter* counter () const { return m_counter; }
+
+    template <typename U>
+    bool operator== (const TrackedAllocator<U>& other) const { return m_counter == other.counter(); }
+
+private:
+    serval::MemoryCounter* m_counter;
+};
+
+/**
+ * @brief Format memory usage as a plain text table, largest live size first
+ * Owners are printed by name, or by id where the engine has no name for them
+ *
+ * @param usage
+ * @return std::string
+ */
+inline std::string serval::format_memory_report (std::span<const serval::MemoryUsage> usage) {
+    std::vector<const serval::MemoryUsage*> rows;
+    rows.reserve(usage.size());
+    for (const auto& entry : usage) {
+        rows.push_back(&entry);
+    }
+    std::sort(rows.begin(), rows.end(), [](auto a, auto b){ return a->live_bytes > b->live_bytes; });
+
+    const auto owner = [](const char* name, serval::Id id) {
+        if (name) {
+            return std::string{name};
+        }
+        if (serval::Id::Type(id) == 0) {
+            return std::string{"-"};
+        }
+        char hex[16];
+        std::snprintf(hex, sizeof(hex), "%08x", serval::Id::Type(id));
+        return std::string{hex};
+    };
+    std::vector<std::string> extensions, systems;
+    extensions.reserve(rows.size());
+    systems.reserve(rows.size());
+    std::size_t extension_width = 9, system_width = 6;
+    for (const auto* row : rows) {
+        extensions.push_back(owner(row->extension_name, row->tag.extension));
+        systems.push_back(owner(row->system_name, row->tag.system));
+        extension_width = std::max(extension_width, extensions.back().size());
+        system_width = std::max(system_width, systems.back().size());
+    }
+
+    // Names are unbounded, so pad the owner columns by hand rather than through snprintf's fixed size buffer
+    const auto column = [](std::string& out, const std::string& text, std::size_t width) {
+        out += text;
+        out.append(width + 2 - text.size(), ' ');
+    };
+    std::string report;
+    column(report, "extension", extension_width);
+    column(report, "system", system_width);
+    report += "live_bytes   peak_bytes   allocations  bytes/s\n";
+    char line[128];
+    for (std::size_t index = 0; index < rows.size(); ++index) {
+        const auto* row = rows[index];
+        column(report, extensions[index], extension_width);
+        column(report, systems[index], system_width);
+        std::snprintf(line, sizeof(line), "%-12lld %-12lld %-12llu %.0f\n",
+            static_cast<long long>(row->live_bytes), static_cast<long long>(row->peak_bytes),
+            static_cast<unsigned long long>(row->allocations), double(row->bytes_per_second));
+        report += line;
+    }
+    return report;
+}
+
+#endif
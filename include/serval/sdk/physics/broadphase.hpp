@@ -0,0 +1,266 @@
+#ifndef SERVAL_SDK__PHYSICS_BROADPHASE_HPP
+#define SERVAL_SDK__PHYSICS_BROADPHASE_HPP
+
+#include "../types.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace serval::physics {
+    class Broadphase;
+
+    // An axis-aligned bounding box, as computed from a resolved shape handle
+    struct Aabb {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    // An overlap between a sensor (TriggerRegion, CollisionSensor or ContactSensor) and a body
+    struct SensorPair {
+        entt::entity sensor;
+        entt::entity body;
+    };
+}
+
+/**
+ * @brief Incremental sweep-and-prune broadphase for sensors and bodies
+ *
+ * Proxies are kept sorted by their minimum x bound. As objects move coherently between frames, re-sorting with an insertion
+ * sort is close to linear, and the sweep only tests sensors against bodies whose x intervals overlap. Proxies added since the
+ * last update are sorted on their own and merged in, so adding many at once (eg the initial population) is O(n log n). Sensor masks are tested
+ * against body layers before the remaining axes are checked, so filtered pairs never reach a narrowphase.
+ *
+ * Overlapping pairs are diffed against the previous call to update(), producing the batches of pairs which entered and exited
+ * since the last update, ready to be published as on_enter/on_exit (or on_contact_begin/on_contact_end) notifications.
+ *
+ * Not thread-safe: call from a single task which has declared `rw` access to the broadphase.
+ */
+class serval::physics::Broadphase {
+public:
+    using Proxy = std::uint32_t;
+    static constexpr Proxy INVALID_PROXY = ~Proxy{0};
+
+    /**
+     * @brief Add a body to the broadphase
+     *
+     * @param entity The entity which owns the body
+     * @param bounds The world-space bounds of the body's shape
+     * @param layers The layers the body belongs to, tested against sensor masks
+     * @return Proxy
+     */
+    Proxy add_body (entt::entity entity, const Aabb& bounds, std::uint8_t layers) {
+        return add_proxy(entity, bounds, layers, false);
+    }
+
+    /**
+     * @brief Add a sensor to the broadphase
+     *
+     * @param entity The entity which owns the sensor
+     * @param bounds The world-space bounds of the sensor's shape
+     * @param mask The sensors mask (eg TriggerRegion::trigger_mask), only bodies with a matching layer are reported
+     * @return Proxy
+     */
+    Proxy add_sensor (entt::entity entity, const Aabb& bounds, std::uint8_t mask) {
+        return add_proxy(entity, bounds, mask, true);
+    }
+
+    /**
+     * @brief Update the bounds of a proxy after its shape has moved
+     *
+     * @param proxy
+     * @param bounds
+     */
+    void move (Proxy proxy, const Aabb& bounds) {
+        ASSERT(proxy < m_proxies.size() && m_proxies[proxy].alive, "Moving an invalid broadphase proxy");
+        m_proxies[proxy].bounds = bounds;
+    }
+
+    /**
+     * @brief Remove a proxy, any pairs it was part of are reported as exited on the next update()
+     *
+     * @param proxy
+     */
+    void remove (Proxy proxy) {
+        ASSERT(proxy < m_proxies.size() && m_proxies[proxy].alive, "Removing an invalid broadphase proxy");
+        m_proxies[proxy].alive = false;
+        m_removed.push_back(proxy);
+    }
+
+    /**
+     * @brief Recompute overlapping pairs and diff them with the previous update
+     *
+     */
+    void update () {
+        // Drop removed proxies from the sort order, the pairs they were part of will be reported as exited by the diff
+        if (!m_removed.empty()) {
+            std::size_t kept = 0;
+            std::size_t kept_sorted = 0;
+            for (std::size_t index = 0; index < m_order.size(); ++index) {
+                if (m_proxies[m_order[index]].alive) {
+                    kept_sorted += index < m_sorted;
+                    m_order[kept++] = m_order[index];
+                }
+            }
+            m_order.resize(kept);
+            m_sorted = kept_sorted;
+        }
+
+        sort();
+        sweep();
+
+        m_entered.clear();
+        m_exited.clear();
+        diff(m_pairs, m_previous_pairs, m_entered);
+        diff(m_previous_pairs, m_pairs, m_exited);
+        std::swap(m_pairs, m_previous_pairs);
+
+        // Slots can only be reused once the exited pairs referencing them have been reported
+        for (auto proxy : m_removed) {
+            m_free.push_back(proxy);
+        }
+        m_removed.clear();
+    }
+
+    /**
+     * @brief Pairs which started overlapping during the last update()
+     *
+     * @return const std::vector<SensorPair>&
+     */
+    const std::vector<SensorPair>& entered () const {
+        return m_entered;
+    }
+
+    /**
+     * @brief Pairs which stopped overlapping (or were removed) during the last update()
+     *
+     * @return const std::vector<SensorPair>&
+     */
+    const std::vector<SensorPair>& exited () const {
+        return m_exited;
+    }
+
+    /**
+     * @brief The number of pairs currently overlapping
+     *
+     * @return std::size_t
+     */
+    std::size_t overlapping () const {
+        return m_previous_pairs.size();
+    }
+
+private:
+    struct ProxyData {
+        Aabb bounds;
+        entt::entity entity;
+        std::uint8_t bits; // Layers for bodies, mask for sensors
+        bool sensor;
+        bool alive;
+    };
+
+    // Pairs are packed into a 64bit key (sensor proxy in the high bits) so that they can be sorted and diffed cheaply
+    using PairKey = std::uint64_t;
+
+    Proxy add_proxy (entt::entity entity, const Aabb& bounds, std::uint8_t bits, bool sensor) {
+        Proxy proxy;
+        if (m_free.empty()) {
+            proxy = Proxy(m_proxies.size());
+            m_proxies.emplace_back();
+        } else {
+            proxy = m_free.back();
+            m_free.pop_back();
+        }
+        m_proxies[proxy] = ProxyData{bounds, entity, bits, sensor, true};
+        m_order.push_back(proxy);
+        return proxy;
+    }
+
+    void sort () {
+        const auto min_x_less = [this](Proxy a, Proxy b){ return m_proxies[a].bounds.min.x < m_proxies[b].bounds.min.x; };
+        // Insertion sort: proxies move little between frames so the order is nearly sorted already
+        for (std::size_t i = 1; i < m_sorted; ++i) {
+            const Proxy proxy = m_order[i];
+            const auto min_x = m_proxies[proxy].bounds.min.x;
+            std::size_t j = i;
+            while (j > 0 && m_proxies[m_order[j - 1]].bounds.min.x > min_x) {
+                m_order[j] = m_order[j - 1];
+                --j;
+            }
+            m_order[j] = proxy;
+        }
+        // Newly added proxies are in no particular order, sort them separately and merge them in
+        if (m_sorted < m_order.size()) {
+            const auto added = m_order.begin() + std::ptrdiff_t(m_sorted);
+            std::sort(added, m_order.end(), min_x_less);
+            std::inplace_merge(m_order.begin(), added, m_order.end(), min_x_less);
+            m_sorted = m_order.size();
+        }
+    }
+
+    static bool overlaps_yz (const Aabb& a, const Aabb& b) {
+        return a.min.y <= b.max.y && b.min.y <= a.max.y && a.min.z <= b.max.z && b.min.z <= a.max.z;
+    }
+
+    void sweep () {
+        m_pairs.clear();
+        m_active_sensors.clear();
+        m_active_bodies.clear();
+        for (const auto proxy : m_order) {
+            const auto& data = m_proxies[proxy];
+            const auto min_x = data.bounds.min.x;
+            // Retire active proxies which end before this one begins
+            const auto retired = [this, min_x](Proxy other){ return m_proxies[other].bounds.max.x < min_x; };
+            m_active_sensors.erase(std::remove_if(m_active_sensors.begin(), m_active_sensors.end(), retired), m_active_sensors.end());
+            m_active_bodies.erase(std::remove_if(m_active_bodies.begin(), m_active_bodies.end(), retired), m_active_bodies.end());
+
+            if (data.sensor) {
+                for (const auto body : m_active_bodies) {
+                    const auto& other = m_proxies[body];
+                    if ((data.bits & other.bits) && overlaps_yz(data.bounds, other.bounds)) {
+                        m_pairs.push_back((PairKey(proxy) << 32) | body);
+                    }
+                }
+                if (data.bits) {
+                    m_active_sensors.push_back(proxy);
+                }
+            } else {
+                for (const auto sensor : m_active_sensors) {
+                    const auto& other = m_proxies[sensor];
+                    if ((data.bits & other.bits) && overlaps_yz(data.bounds, other.bounds)) {
+                        m_pairs.push_back((PairKey(sensor) << 32) | proxy);
+                    }
+                }
+                if (data.bits) {
+                    m_active_bodies.push_back(proxy);
+                }
+            }
+        }
+        std::sort(m_pairs.begin(), m_pairs.end());
+    }
+
+    // Append the pairs in `a` but not in `b` (both sorted) to `out`
+    void diff (const std::vector<PairKey>& a, const std::vector<PairKey>& b, std::vector<SensorPair>& out) const {
+        auto it = b.begin();
+        for (const auto key : a) {
+            while (it != b.end() && *it < key) {
+                ++it;
+            }
+            if (it == b.end() || *it != key) {
+                out.push_back({m_proxies[Proxy(key >> 32)].entity, m_proxies[Proxy(key & 0xffffffff)].entity});
+            }
+        }
+    }
+
+    std::vector<ProxyData> m_proxies;
+    std::vector<Proxy> m_order;
+    std::size_t m_sorted = 0; // The length of the prefix of m_order which was sorted by the last update, the rest were added since
+    std::vector<Proxy> m_free;
+    std::vector<Proxy> m_removed;
+    std::vector<Proxy> m_active_sensors;
+    std::vector<Proxy> m_active_bodies;
+    std::vector<PairKey> m_pairs;
+    std::vector<PairKey> m_previous_pairs;
+    std::vector<SensorPair> m_entered;
+    std::vector<SensorPair> m_exited;
+};
+
+#endif
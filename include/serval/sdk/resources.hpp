@@ -0,0 +1,71 @@
+#ifndef SERVAL_SDK__RESOURCES_HPP
+#define SERVAL_SDK__RESOURCES_HPP
+
+#include "types.hpp"
+
+namespace serval {
+    /**
+     * @brief Engine-owned table of all loaded resources of one type
+     * Slots are indexed by handles::index(), the engine only mutates the table between frames.
+     * Generations are stored in 16 bits but hold 12-bit handle generations, advanced with handles::next_generation()
+     *
+     */
+    struct ResourceSlots {
+        serval::Id type;
+        std::uint32_t size;
+        void* const* resources;
+        const std::uint16_t* generations;
+    };
+
+    template <typename Resource>
+    class ResourceView;
+}
+
+/**
+ * @brief Typed, inline access to a resource table
+ * Resolving a handle is a bounds and generation check followed by a load, with no call into the engine.
+ * Fetch the view once (Runtime::resources<Resource>()) and reuse it for every lookup in a task.
+ * A view of a type with no table (eg no resources of it were ever loaded) is empty, every handle is invalid.
+ *
+ * @tparam Resource
+ */
+template <typename Resource>
+class serval::ResourceView {
+public:
+    explicit ResourceView (const serval::ResourceSlots* slots) : m_slots(slots ? slots : &EMPTY) {
+        ASSERT(m_slots->type == Resource::ResourceTypeID || m_slots == &EMPTY, "Resource table type does not match the requested resource type");
+    }
+
+    /**
+     * @brief Retrieve a resource from a handle
+     *
+     * @param handle The handle to the resource
+     * @return Resource* A pointer to the resource, or nullptr if the handle is stale or invalid
+     */
+    Resource* resolve (serval::Handle handle) const {
+        const auto index = serval::handles::index(handle);
+        if EXPECT_TAKEN(index < m_slots->size && m_slots->generations[index] == serval::handles::generation(handle)) {
+            return static_cast<Resource*>(m_slots->resources[index]);
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Check if a handle refers to a live resource
+     *
+     * @param handle
+     * @return true The handle resolves to a resource
+     * @return false The handle is stale or invalid
+     */
+    bool valid (serval::Handle handle) const {
+        const auto index = serval::handles::index(handle);
+        return index < m_slots->size && m_slots->generations[index] == serval::handles::generation(handle);
+    }
+
+private:
+    static constexpr serval::ResourceSlots EMPTY{Resource::ResourceTypeID, 0, nullptr, nullptr};
+
+    const serval::ResourceSlots* m_slots;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#ifndef SERVAL_SDK__SCHEDULING_HPP
+#define SERVAL_SDK__SCHEDULING_HPP
+
+#include "types.hpp"
+
+#include <spdlog/fmt/fmt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace serval {
+    enum class TaskPriority : std::uint8_t {
+        Normal,    // Run as soon as a worker is free
+        Deferred,  // Run only when a worker would otherwise be idle and the scheduler's frame budget has time left
+    };
+
+    class TaskGraph;
+}
+
+/**
+ * @brief Dependency graph of a scheduler's tasks, dispatched critical path first
+ *
+ * Each task's duration is tracked as a moving average of its measured run times. update() computes every task's
+ * priority as the length of the longest (by duration) path from the task to the end of the frame, including itself.
+ * Dispatching the ready task with the highest priority first starts long dependency chains early, which shortens the
+ * frame on machines with many workers without any change to the tasks themselves.
+ *
+ * Building the graph and update() are single-threaded, between frames. During a frame, any worker may call pop(),
+ * complete() and record().
+ */
+class serval::TaskGraph {
+public:
+    using Index = std::uint32_t;
+
+    /**
+     * @param smoothing Weight of each new measurement in the moving average of a task's duration
+     * @param default_ms Duration assumed for a task until it has been measured
+     */
+    explicit TaskGraph (float smoothing=0.2f, float default_ms=0.05f) : m_smoothing(smoothing), m_default_ms(default_ms) {}
+
+    Index add_task () {
+        m_durations.push_back(m_default_ms);
+        m_levels.push_back(m_default_ms);
+        m_dirty = true;
+        return Index(m_durations.size() - 1);
+    }
+
+    /**
+     * @brief Declare that `after` may not start until `before` has completed
+     *
+     * @param before
+     * @param after
+     */
+    void add_dependency (Index before, Index after) {
+        m_edges.push_back({before, after});
+        m_dirty = true;
+    }
+
+    void clear () {
+        m_durations.clear();
+        m_levels.clear();
+        m_edges.clear();
+        m_dirty = true;
+    }
+
+    std::size_t size () const {
+        return m_durations.size();
+    }
+
+    /**
+     * @brief Record a measured run time of a task
+     * Safe to call concurrently for different tasks
+     *
+     * @param task
+     * @param milliseconds
+     */
+    void record (Index task, float milliseconds) {
+        m_durations[task] += (milliseconds - m_durations[task]) * m_smoothing;
+    }
+
+    /**
+     * @brief Recompute task priorities from the recorded durations, call between frames
+     * O(tasks + dependencies), the topological order is only rebuilt when the graph has changed.
+     * Throws std::logic_error if the dependencies contain a cycle, since the tasks on it could never run.
+     *
+     */
+    void update () {
+        if (m_dirty) {
+            rebuild();
+        }
+        m_critical_path_ms = 0;
+        // Reverse topological order: every successor's level is final before its predecessors read it
+        for (auto it = m_order.rbegin(); it != m_order.rend(); ++it) {
+            const auto task = *it;
+            float longest = 0;
+            for (auto edge = m_offsets[task]; edge < m_offsets[task + 1]; ++edge) {
+                longest = std::max(longest, m_levels[m_successors[edge]]);
+            }
+            m_levels[task] = m_durations[task] + longest;
+            m_critical_path_ms = std::max(m_critical_path_ms, m_levels[task]);
+        }
+    }
+
+    /**
+     * @brief The length of the longest path from the task to the end of the frame, as of the last update()
+     *
+     * @param task
+     * @return float Milliseconds
+     */
+    float priority (Index task) const {
+        return m_levels[task];
+    }
+
+    float duration_ms (Index task) const {
+        return m_durations[task];
+    }
+
+    /**
+     * @brief The shortest possible frame time with unlimited workers, as of the last update()
+     *
+     * @return float Milliseconds
+     */
+    float critical_path_ms () const {
+        return m_critical_path_ms;
+    }
+
+    /**
+     * @brief Make the tasks without dependencies ready, call at the start of each frame after update()
+     * Throws std::logic_error if the graph changed and its dependencies contain a cycle, see update()
+     *
+     */
+    void begin_frame () {
+        if (m_dirty) {
+            update();
+        }
+        std::scoped_lock lock{m_mutex};
+        m_ready.clear();
+        m_remaining.store(std::uint32_t(size()), std::memory_order_relaxed);
+        for (Index task = 0; task < size(); ++task) {
+            m_pending[task].store(m_predecessors[task], std::memory_order_relaxed);
+            if (m_predecessors[task] == 0) {
+                push_ready(task);
+            }
+        }
+    }
+
+    /**
+     * @brief Take the ready task with the longest path to the end of the frame
+     *
+     * @param task Set to the task to run
+     * @return true A task was ready
+     * @return false No task is ready, either the frame is finished() or all remaining tasks wait on running ones
+     */
+    bool pop (Index& task) {
+        std::scoped_lock lock{m_mutex};
+        if (m_ready.empty()) {
+            return false;
+        }
+        std::pop_heap(m_ready.begin(), m_ready.end(), [this](Index a, Index b){ return m_levels[a] < m_levels[b]; });
+        task = m_ready.back();
+        m_ready.pop_back();
+        return true;
+    }
+
+    /**
+     * @brief Mark a task popped by pop() as completed, making any tasks which were only waiting on it ready
+     *
+     * @param task
+     */
+    void complete (Index task) {
+        for (auto edge = m_offsets[task]; edge < m_offsets[task + 1]; ++edge) {
+            const auto successor = m_successors[edge];
+            if (m_pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::scoped_lock lock{m_mutex};
+                push_ready(successor);
+            }
+        }
+        m_remaining.fetch_sub(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Check if every task has completed this frame
+     *
+     * @return true
+     * @return false
+     */
+    bool finished () const {
+        return m_remaining.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    struct Edge {
+        Index before;
+        Index after;
+    };
+
+    void push_ready (Index task) {
+        m_ready.push_back(task);
+        std::push_heap(m_ready.begin(), m_ready.end(), [this](Index a, Index b){ return m_levels[a] < m_levels[b]; });
+    }
+
+    // Build the successor lists (compressed, indexed by m_offsets) and a topological order
+    void rebuild () {
+        const auto count = size();
+        m_offsets.assign(count + 1, 0);
+        m_predecessors.assign(count, 0);
+        for (const auto& edge : m_edges) {
+            ++m_offsets[edge.before + 1];
+            ++m_predecessors[edge.after];
+        }
+        for (std::size_t task = 0; task < count; ++task) {
+            m_offsets[task + 1] += m_offsets[task];
+        }
+        m_successors.resize(m_edges.size());
+        std::vector<std::uint32_t> cursor(m_offsets.begin(), m_offsets.end() - 1);
+        for (const auto& edge : m_edges) {
+            m_successors[cursor[edge.before]++] = edge.after;
+        }
+
+        m_order.clear();
+        std::vector<std::uint32_t> pending = m_predecessors;
+        for (Index task = 0; task < count; ++task) {
+            if (pending[task] == 0) {
+                m_order.push_back(task);
+            }
+        }
+        for (std::size_t next = 0; next < m_order.size(); ++next) {
+            const auto task = m_order[next];
+            for (auto edge = m_offsets[task]; edge < m_offsets[task + 1]; ++edge) {
+                if (--pending[m_successors[edge]] == 0) {
+                    m_order.push_back(m_successors[edge]);
+                }
+            }
+        }
+        // The graph stays dirty, so every later update() reports the cycle again until it is fixed
+        REQUIRE(m_order.size() == count, "Task dependencies contain a cycle ({} of {} tasks are on or after it)", count - m_order.size(), count);
+
+        m_pending = std::make_unique<std::atomic<std::uint32_t>[]>(count);
+        m_ready.reserve(count);
+        m_dirty = false;
+    }
+
+    float m_smoothing;
+    float m_default_ms;
+    float m_critical_path_ms = 0;
+    bool m_dirty = true;
+    std::vector<float> m_durations;
+    std::vector<float> m_levels;
+    std::vector<Edge> m_edges;
+    std::vector<std::uint32_t> m_offsets;
+    std::vector<Index> m_successors;
+    std::vector<std::uint32_t> m_predecessors;
+    std::vector<Index> m_order;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> m_pending;
+    std::atomic<std::uint32_t> m_remaining = 0;
+    std::mutex m_mutex;
+    std::vector<Index> m_ready;
+};
+
+#endif
@@ -0,0 +1,460 @@
+#ifndef SERVAL_SDK__SERIALIZATION_HPP
+#define SERVAL_SDK__SERIALIZATION_HPP
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Binary save format
+ *
+ * A save is a sequence of sections. Each section starts with a 16 byte header holding a tag (usually the system or state
+ * name), a version and the size of its payload, so readers can skip sections they don't know or whose version they
+ * don't support. Sections can be nested.
+ *
+ * Arrays are stored aligned to their element type (at least 8 bytes), so arrays of trivially copyable types (components,
+ * entities, etc) are read back in place from the buffer, which may be a memory-mapped save file, without copying.
+ */
+namespace serval {
+    struct SectionHeader {
+        serval::Id tag;
+        std::uint32_t version;
+        std::uint64_t size;
+    };
+    static_assert(sizeof(SectionHeader) == 16);
+
+    // Sections begin on 16 byte boundaries so that their payloads can hold SIMD-aligned values
+    static constexpr std::size_t SECTION_ALIGNMENT = 16;
+
+    // An entry in a section index, as written by Writer::write_indexed()
+    struct SectionIndexEntry {
+        serval::Id tag;
+        std::uint32_t version;
+        std::uint64_t offset; // Of the section's header, from the start of the index section
+    };
+    static_assert(sizeof(SectionIndexEntry) == 16);
+
+    static constexpr serval::Id SECTION_INDEX_TAG = "serval/section-index"_hs;
+
+    class Reader;
+    class Writer;
+
+    /**
+     * @brief The changes to one component type in a delta save segment
+     * 
+     * @tparam Component
+     */
+    template <typename Component>
+    struct ComponentDelta {
+        std::span<const entt::entity> changed;  // Entities whose component was added or written
+        std::span<const Component> values;      // The new values, parallel to `changed`
+        std::span<const entt::entity> removed;  // Entities whose component was removed, or which were destroyed
+    };
+
+    template <typename Component>
+    void write_delta (serval::Writer& writer, const serval::ComponentDelta<Component>& delta);
+
+    template <typename Component>
+    bool read_delta (serval::Reader& reader, serval::ComponentDelta<Component>& delta);
+}
+
+class serval::Writer {
+public:
+    Writer () = default;
+
+    /**
+     * @brief Begin a new section, must be matched by a call to end_section()
+     *
+     * @param tag The tag identifying the section
+     * @param version The version of the section's format
+     */
+    void begin_section (serval::Id tag, std::uint32_t version) {
+        align(SECTION_ALIGNMENT);
+        m_open_sections.push_back(m_buffer.size());
+        const SectionHeader header{tag, version, 0};
+        append(&header, sizeof(header));
+    }
+
+    /**
+     * @brief End the most recently begun section
+     *
+     */
+    void end_section () {
+        ASSERT(!m_open_sections.empty(), "end_section() called without a matching begin_section()");
+        align(SECTION_ALIGNMENT);
+        const auto start = m_open_sections.back();
+        m_open_sections.pop_back();
+        const std::uint64_t size = m_buffer.size() - start - sizeof(SectionHeader);
+        std::memcpy(m_buffer.data() + start + offsetof(SectionHeader, size), &size, sizeof(size));
+    }
+
+    // A section written independently into its own writer
+    struct Part {
+        serval::Id tag;
+        std::uint32_t version;
+        const Writer* writer;
+    };
+
+    /**
+     * @brief Append the contents of another writer as a section
+     *
+     * @param tag The tag identifying the section
+     * @param version The version of the section's format
+     * @param payload The section's contents
+     */
+    void append_section (serval::Id tag, std::uint32_t version, const Writer& payload) {
+        ASSERT(payload.m_open_sections.empty(), "Appending a writer with unterminated sections");
+        begin_section(tag, version);
+        append(payload.m_buffer.data(), payload.m_buffer.size());
+        end_section();
+    }
+
+    /**
+     * @brief Stitch independently written sections together, preceded by an index of their offsets
+     * Lets sections be written concurrently into separate writers (eg one per system), and lets Reader::read_index() open
+     * every section directly so that they can also be read concurrently.
+     *
+     * @param parts The sections to write
+     */
+    void write_indexed (std::span<const Part> parts) {
+        std::vector<SectionIndexEntry> index;
+        index.reserve(parts.size());
+        std::size_t total = 0;
+        for (const auto& part : parts) {
+            index.push_back({part.tag, part.version, 0});
+            total += sizeof(SectionHeader) + part.writer->m_buffer.size() + SECTION_ALIGNMENT;
+        }
+        reserve(total + (index.size() + 2) * sizeof(SectionIndexEntry));
+
+        align(SECTION_ALIGNMENT);
+        const auto index_start = m_buffer.size();
+        begin_section(SECTION_INDEX_TAG, 1);
+        write(std::span<const SectionIndexEntry>{index});
+        const auto entries_start = m_buffer.size() - index.size() * sizeof(SectionIndexEntry);
+        end_section();
+
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            align(SECTION_ALIGNMENT);
+            const std::uint64_t offset = m_buffer.size() - index_start;
+            std::memcpy(m_buffer.data() + entries_start + i * sizeof(SectionIndexEntry) + offsetof(SectionIndexEntry, offset), &offset, sizeof(offset));
+            append_section(parts[i].tag, parts[i].version, *parts[i].writer);
+        }
+    }
+
+    /**
+     * @brief Write a single trivially copyable value
+     *
+     * @tparam T
+     * @param value
+     */
+    template <typename T>
+    void write (const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written directly");
+        align(alignof(T));
+        append(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Write an array of trivially copyable values, which Reader::read_span() can read back in place
+     *
+     * @tparam T
+     * @param values
+     */
+    template <typename T>
+    void write (std::span<const T> values) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be written directly");
+        write(std::uint64_t(values.size()));
+        align(alignof(T) > ARRAY_ALIGNMENT ? alignof(T) : ARRAY_ALIGNMENT);
+        append(values.data(), values.size_bytes());
+    }
+
+    // Spans of mutable or fixed-extent elements would otherwise bind to the single value overload and write the span itself
+    template <typename T, std::size_t Extent>
+    void write (std::span<T, Extent> values) {
+        write(std::span<const T>{values});
+    }
+
+    template <typename T>
+    void write (const std::vector<T>& values) {
+        write(std::span<const T>{values});
+    }
+
+    /**
+     * @brief Write a length-prefixed string
+     *
+     * @param string
+     */
+    void write (std::string_view string) {
+        write(std::uint64_t(string.size()));
+        append(string.data(), string.size());
+    }
+
+    void write (const char* string) {
+        write(std::string_view{string});
+    }
+
+    /**
+     * @brief Reserve space ahead of writing, to avoid reallocating while writing large sections
+     *
+     * @param bytes
+     */
+    void reserve (std::size_t bytes) {
+        m_buffer.reserve(m_buffer.size() + bytes);
+    }
+
+    /**
+     * @brief The written data
+     *
+     * @return std::span<const std::byte>
+     */
+    std::span<const std::byte> data () const {
+        ASSERT(m_open_sections.empty(), "Writer data accessed with unterminated sections");
+        return m_buffer;
+    }
+
+    void clear () {
+        m_buffer.clear();
+        m_open_sections.clear();
+    }
+
+private:
+    static constexpr std::size_t ARRAY_ALIGNMENT = 8;
+
+    void align (std::size_t alignment) {
+        m_buffer.resize((m_buffer.size() + alignment - 1) & ~(alignment - 1), std::byte{0});
+    }
+
+    void append (const void* data, std::size_t size) {
+        const auto offset = m_buffer.size();
+        m_buffer.resize(offset + size);
+        if (size > 0) {
+            std::memcpy(m_buffer.data() + offset, data, size);
+        }
+    }
+
+    std::vector<std::byte> m_buffer;
+    std::vector<std::size_t> m_open_sections;
+};
+
+class serval::Reader {
+public:
+    struct Section;
+
+    Reader () = default;
+
+    /**
+     * @brief Read from a buffer, which must be at least 16 byte aligned and outlive any spans read from it
+     *
+     * @param data
+     */
+    explicit Reader (std::span<const std::byte> data) : m_data(data) {}
+
+    /**
+     * @brief Read the next section, skipping over any data remaining before it
+     *
+     * @param section The section's header and a reader for its contents
+     * @return true A section was read
+     * @return false There are no more sections (or the data is truncated)
+     */
+    bool next (Section& section);
+
+    /**
+     * @brief Find a sibling section by tag, searching from the beginning of this reader's data
+     *
+     * @param tag The section's tag
+     * @param section The section's header and a reader for its contents
+     * @return true The section was found
+     * @return false The section was not found
+     */
+    bool find (serval::Id tag, Section& section) const;
+
+    /**
+     * @brief Open every section listed by an index written with Writer::write_indexed(), without scanning through them
+     * On success, reading continues after the last indexed section
+     *
+     * @param sections Receives the indexed sections, in the order they were written
+     * @return true The index was read
+     * @return false The next section is not an index, or the data is invalid
+     */
+    bool read_index (std::vector<Section>& sections);
+
+    /**
+     * @brief Read a single trivially copyable value
+     *
+     * @tparam T
+     * @param out
+     * @return true The value was read
+     * @return false The data was truncated
+     */
+    template <typename T>
+    bool read (T& out) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read directly");
+        align(alignof(T));
+        if EXPECT_NOT_TAKEN(!has(sizeof(T))) {
+            return false;
+        }
+        std::memcpy(&out, m_data.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return true;
+    }
+
+    /**
+     * @brief Read an array of trivially copyable values in place, without copying
+     *
+     * @tparam T
+     * @return std::span<const T> The array (empty if the data was truncated)
+     */
+    template <typename T>
+    std::span<const T> read_span () {
+        static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable types can be read directly");
+        std::uint64_t count = 0;
+        if EXPECT_NOT_TAKEN(!read(count)) {
+            return {};
+        }
+        align(alignof(T) > ARRAY_ALIGNMENT ? alignof(T) : ARRAY_ALIGNMENT);
+        if EXPECT_NOT_TAKEN(count > (m_data.size() - std::min(m_offset, m_data.size())) / sizeof(T)) {
+            m_failed = true;
+            return {};
+        }
+        const auto* values = reinterpret_cast<const T*>(m_data.data() + m_offset);
+        m_offset += count * sizeof(T);
+        return {values, std::size_t(count)};
+    }
+
+    /**
+     * @brief Read a length-prefixed string in place
+     *
+     * @return std::string_view The string (empty if the data was truncated)
+     */
+    std::string_view read_string () {
+        std::uint64_t size = 0;
+        if EXPECT_NOT_TAKEN(!read(size) || !has(size)) {
+            return {};
+        }
+        const auto* chars = reinterpret_cast<const char*>(m_data.data() + m_offset);
+        m_offset += size;
+        return {chars, std::size_t(size)};
+    }
+
+    /**
+     * @brief Check if all reads so far have succeeded
+     *
+     * @return true
+     * @return false A read went past the end of the data
+     */
+    bool good () const {
+        return !m_failed;
+    }
+
+    /**
+     * @brief Check if all data has been read
+     *
+     * @return true
+     * @return false
+     */
+    bool done () const {
+        return m_offset >= m_data.size();
+    }
+
+private:
+    static constexpr std::size_t ARRAY_ALIGNMENT = 8;
+
+    void align (std::size_t alignment) {
+        m_offset = (m_offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool has (std::uint64_t size) {
+        if (m_offset > m_data.size() || size > m_data.size() - m_offset) {
+            m_failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    std::span<const std::byte> m_data;
+    std::size_t m_offset = 0;
+    bool m_failed = false;
+};
+
+struct serval::Reader::Section {
+    serval::Id tag;
+    std::uint32_t version;
+    serval::Reader reader;
+};
+
+inline bool serval::Reader::next (Section& section) {
+    align(SECTION_ALIGNMENT);
+    SectionHeader header;
+    if (done() || !read(header) || !has(header.size)) {
+        return false;
+    }
+    section.tag = header.tag;
+    section.version = header.version;
+    section.reader = Reader{m_data.subspan(m_offset, std::size_t(header.size))};
+    m_offset += header.size;
+    return true;
+}
+
+inline bool serval::Reader::find (serval::Id tag, Section& section) const {
+    Reader reader{m_data};
+    while (reader.next(section)) {
+        if (section.tag == tag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool serval::Reader::read_index (std::vector<Section>& sections) {
+    align(SECTION_ALIGNMENT);
+    const auto start = m_offset;
+    Section index;
+    if (!next(index) || index.tag != SECTION_INDEX_TAG) {
+        m_offset = start;
+        return false;
+    }
+    const auto entries = index.reader.read_span<SectionIndexEntry>();
+    if (!index.reader.good()) {
+        m_failed = true;
+        return false;
+    }
+    sections.resize(entries.size());
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        if (entry.offset > m_data.size() - start) {
+            m_failed = true;
+            return false;
+        }
+        Reader reader{m_data.subspan(start + std::size_t(entry.offset))};
+        if (!reader.next(sections[i]) || sections[i].tag != entry.tag) {
+            m_failed = true;
+            return false;
+        }
+        m_offset = std::max(m_offset, start + std::size_t(entry.offset) + reader.m_offset);
+    }
+    return true;
+}
+
+template <typename Component>
+void serval::write_delta (serval::Writer& writer, const serval::ComponentDelta<Component>& delta) {
+    ASSERT(delta.changed.size() == delta.values.size(), "Component delta has mismatched entities and values");
+    writer.write(delta.changed);
+    writer.write(delta.values);
+    writer.write(delta.removed);
+}
+
+template <typename Component>
+bool serval::read_delta (serval::Reader& reader, serval::ComponentDelta<Component>& delta) {
+    delta.changed = reader.read_span<entt::entity>();
+    delta.values = reader.read_span<Component>();
+    delta.removed = reader.read_span<entt::entity>();
+    return reader.good() && delta.changed.size() == delta.values.size();
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef SERVAL_SDK__SLAB_HPP
+#define SERVAL_SDK__SLAB_HPP
+
+#include "types.hpp"
+#include "memory.hpp"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace serval {
+    class SlabAllocator;
+}
+
+/**
+ * @brief Pooled allocator for long-lived engine objects created through serval::FactoryFn, such as systems and game states
+ *
+ * Objects are placed contiguously in large slabs. Every allocation starts on a cache line and is padded to a whole number of
+ * cache lines, so objects updated from different workers never share a line. Alignments above a cache line (eg for SIMD
+ * members) are honoured. Freed blocks are kept on per-size free lists and reused by later allocations of the same size.
+ *
+ * If given a MemoryCounter, the padded size of every live object is recorded against it.
+ *
+ * Not thread-safe, objects are created and destroyed while no tasks are running.
+ */
+class serval::SlabAllocator {
+public:
+    explicit SlabAllocator (std::size_t slab_size=64 * 1024, serval::MemoryCounter* counter=nullptr) : m_slab_size(slab_size), m_counter(counter) {}
+    SlabAllocator (const SlabAllocator&) = delete;
+    SlabAllocator& operator= (const SlabAllocator&) = delete;
+
+    ~SlabAllocator () {
+        for (const auto& slab : m_slabs) {
+            ::operator delete(slab.memory, std::align_val_t{slab.alignment});
+        }
+    }
+
+    /**
+     * @brief Allocate and construct an object
+     *
+     * @tparam Class
+     * @param factory
+     * @return Class* The new object
+     */
+    template <typename Class>
+    Class* create (const serval::FactoryFn<Class>& factory) {
+        return factory(allocate(factory.size, factory.alignment));
+    }
+
+    /**
+     * @brief Destroy and free an object created by create()
+     *
+     * @tparam Class
+     * @param factory The factory the object was created with
+     * @param object
+     */
+    template <typename Class>
+    void destroy (const serval::FactoryFn<Class>& factory, Class* object) {
+        deallocate(factory.destroy(object), factory.size, factory.alignment);
+    }
+
+    /**
+     * @brief Allocate a cache line aligned block
+     *
+     * @param size
+     * @param alignment
+     * @return void*
+     */
+    void* allocate (std::size_t size, std::size_t alignment) {
+        alignment = std::max(alignment, CACHE_LINE_SIZE);
+        size = round_up(std::max<std::size_t>(size, 1), CACHE_LINE_SIZE);
+        if (m_counter) {
+            m_counter->allocated(size);
+        }
+        for (auto& list : m_free) {
+            if (list.size == size && list.alignment == alignment && !list.blocks.empty()) {
+                void* block = list.blocks.back();
+                list.blocks.pop_back();
+                return block;
+            }
+        }
+        if (m_slabs.empty() || !fits(m_slabs.back(), size, alignment)) {
+            const auto slab_alignment = std::max(alignment, CACHE_LINE_SIZE);
+            const auto slab_size = round_up(std::max(m_slab_size, size), slab_alignment);
+            m_slabs.push_back({static_cast<std::byte*>(::operator new(slab_size, std::align_val_t{slab_alignment})), slab_size, 0, slab_alignment});
+        }
+        auto& slab = m_slabs.back();
+        slab.used = round_up(slab.used, alignment);
+        void* block = slab.memory + slab.used;
+        slab.used += size;
+        return block;
+    }
+
+    /**
+     * @brief Return a block to the pool
+     *
+     * @param block
+     * @param size The size passed to allocate()
+     * @param alignment The alignment passed to allocate()
+     */
+    void deallocate (void* block, std::size_t size, std::size_t alignment) {
+        alignment = std::max(alignment, CACHE_LINE_SIZE);
+        size = round_up(std::max<std::size_t>(size, 1), CACHE_LINE_SIZE);
+        if (m_counter) {
+            m_counter->freed(size);
+        }
+        for (auto& list : m_free) {
+            if (list.size == size && list.alignment == alignment) {
+                list.blocks.push_back(block);
+                return;
+            }
+        }
+        m_free.push_back({size, alignment, {block}});
+    }
+
+private:
+    struct Slab {
+        std::byte* memory;
+        std::size_t size;
+        std::size_t used;
+        std::size_t alignment;
+    };
+
+    struct FreeList {
+        std::size_t size;
+        std::size_t alignment;
+        std::vector<void*> blocks;
+    };
+
+    static std::size_t round_up (std::size_t value, std::size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    static bool fits (const Slab& slab, std::size_t size, std::size_t alignment) {
+        // Slab memory is aligned to slab.alignment, offsets are only aligned if the slab is at least as aligned
+        return slab.alignment >= alignment && round_up(slab.used, alignment) + size <= slab.size;
+    }
+
+    std::size_t m_slab_size;
+    serval::MemoryCounter* m_counter;
+    std::vector<Slab> m_slabs;
+    std::vector<FreeList> m_free;
+};
+
+#endif
@@ -0,0 +1,356 @@
+#ifndef SERVAL_SDK__SPATIAL_HPP
+#define SERVAL_SDK__SPATIAL_HPP
+
+#include "types.hpp"
+#include "components/core.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace serval {
+    class SpatialIndex;
+
+    // A result of a k-nearest query
+    struct Neighbour {
+        entt::entity entity;
+        serval::Scalar distance_squared;
+    };
+}
+
+/**
+ * @brief Uniform hashed grid of entity positions
+ *
+ * The engine rebuilds the index once per frame from core::Position, after which it is immutable for the rest of the frame.
+ * All queries are const and allocation-free, so they are safe to call concurrently from parallel tasks. Results are written
+ * into caller-provided buffers, and queries stop once the buffer is full.
+ *
+ * Cells are hashed into a fixed size bucket table, so the world does not need to be bounded. Entries store their position
+ * alongside the entity, keeping distance tests on contiguous memory rather than chasing component storages.
+ */
+class serval::SpatialIndex {
+public:
+    explicit SpatialIndex (serval::Scalar cell_size=8.0f) : m_cell_size(cell_size), m_inverse_cell_size(1.0f / cell_size) {}
+
+    /**
+     * @brief Rebuild the index
+     * Accepts any iterable of (entity, position) pairs, such as `registry.view<const components::core::Position>().each()`
+     *
+     * @tparam Iterable
+     * @param entities_and_positions
+     */
+    template <typename Iterable>
+    void build (Iterable&& entities_and_positions) {
+        m_entries.clear();
+        for (auto [entity, position] : entities_and_positions) {
+            m_entries.push_back({glm::vec3{position.x, position.y, position.z}, entity, 0});
+        }
+        finalize();
+    }
+
+    /**
+     * @brief The size of a grid cell, queries are most efficient when radii are close to this size
+     *
+     * @return serval::Scalar
+     */
+    serval::Scalar cell_size () const {
+        return m_cell_size;
+    }
+
+    /**
+     * @brief The number of indexed entities
+     *
+     * @return std::size_t
+     */
+    std::size_t size () const {
+        return m_sorted.size();
+    }
+
+    /**
+     * @brief Find entities within `radius` of `center`
+     *
+     * @param center
+     * @param radius
+     * @param out Buffer to receive the results
+     * @return std::size_t The number of entities written to `out`
+     */
+    std::size_t query_radius (const glm::vec3& center, serval::Scalar radius, std::span<entt::entity> out) const {
+        if (out.empty()) {
+            return 0;
+        }
+        const auto radius_squared = radius * radius;
+        std::size_t count = 0;
+        for_each_cell(center - glm::vec3{radius}, center + glm::vec3{radius}, [&](const Entry& entry) {
+            const auto offset = entry.position - center;
+            if (glm::dot(offset, offset) <= radius_squared) {
+                out[count++] = entry.entity;
+            }
+            return count < out.size();
+        });
+        return count;
+    }
+
+    /**
+     * @brief Find entities inside an axis-aligned box
+     *
+     * @param min The minimum corner of the box
+     * @param max The maximum corner of the box
+     * @param out Buffer to receive the results
+     * @return std::size_t The number of entities written to `out`
+     */
+    std::size_t query_box (const glm::vec3& min, const glm::vec3& max, std::span<entt::entity> out) const {
+        if (out.empty()) {
+            return 0;
+        }
+        std::size_t count = 0;
+        for_each_cell(min, max, [&](const Entry& entry) {
+            const auto& p = entry.position;
+            if (p.x >= min.x && p.y >= min.y && p.z >= min.z && p.x <= max.x && p.y <= max.y && p.z <= max.z) {
+                out[count++] = entry.entity;
+            }
+            return count < out.size();
+        });
+        return count;
+    }
+
+    /**
+     * @brief Find entities within `radius` of a line segment, eg for line-of-sight or projectile sweeps
+     *
+     * @param origin The start of the segment
+     * @param direction The normalised direction of the segment
+     * @param length The length of the segment
+     * @param radius The maximum distance from the segment
+     * @param out Buffer to receive the results (unordered)
+     * @return std::size_t The number of entities written to `out`
+     */
+    std::size_t query_ray (const glm::vec3& origin, const glm::vec3& direction, serval::Scalar length, serval::Scalar radius, std::span<entt::entity> out) const {
+        if (out.empty() || m_sorted.empty()) {
+            return 0;
+        }
+        const auto radius_squared = radius * radius;
+        // Walk slabs of cells along the dominant axis, visiting only the cells that the capsule overlaps in each slab.
+        // Slabs are disjoint, so no cell is visited twice.
+        const auto abs_direction = glm::abs(direction);
+        const int axis = abs_direction.x >= abs_direction.y ? (abs_direction.x >= abs_direction.z ? 0 : 2) : (abs_direction.y >= abs_direction.z ? 1 : 2);
+        // A zero direction is a point, whatever the length (which may be infinite)
+        const auto reach = abs_direction[axis] > 0.0f ? length : 0.0f;
+        const auto end = origin + direction * reach;
+        // Only walk the slabs covering the indexed bounds, clamped before converting to cells so that long rays can't overflow
+        const auto lo = std::max(std::min(origin[axis], end[axis]) - radius, m_bounds_min[axis]);
+        const auto hi = std::min(std::max(origin[axis], end[axis]) + radius, m_bounds_max[axis]);
+        if (!(lo <= hi)) {
+            return 0;
+        }
+        std::size_t count = 0;
+        const auto last_slab = cell_of(hi);
+        for (auto slab = cell_of(lo); slab <= last_slab; ++slab) {
+            // The part of the segment whose dominant coordinate lies in this slab (expanded by radius)
+            const auto slab_lo = slab * m_cell_size - radius;
+            const auto slab_hi = (slab + 1) * m_cell_size + radius;
+            auto t0 = 0.0f;
+            auto t1 = reach;
+            if (abs_direction[axis] > 0.0f) {
+                t0 = (slab_lo - origin[axis]) / direction[axis];
+                t1 = (slab_hi - origin[axis]) / direction[axis];
+                if (t0 > t1) {
+                    std::swap(t0, t1);
+                }
+                t0 = std::clamp(t0, 0.0f, length);
+                t1 = std::clamp(t1, 0.0f, length);
+            }
+            auto min = glm::min(origin + direction * t0, origin + direction * t1) - glm::vec3{radius};
+            auto max = glm::max(origin + direction * t0, origin + direction * t1) + glm::vec3{radius};
+            // Any point in the slab selects it, clamped to the bounds so that for_each_cell() doesn't clip the end slabs away
+            min[axis] = std::clamp((slab + 0.5f) * m_cell_size, m_bounds_min[axis], m_bounds_max[axis]);
+            max[axis] = min[axis];
+            const bool more = for_each_cell(min, max, [&](const Entry& entry) {
+                const auto offset = entry.position - origin;
+                const auto t = std::clamp(glm::dot(offset, direction), 0.0f, length);
+                const auto closest = offset - direction * t;
+                if (glm::dot(closest, closest) <= radius_squared) {
+                    out[count++] = entry.entity;
+                }
+                return count < out.size();
+            });
+            if (!more) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * @brief Find the nearest entities to `center`
+     * Searches rings of cells outwards from `center` until the k-th nearest result is known, where k is `out.size()`
+     *
+     * @param center
+     * @param out Buffer to receive the results, sorted from nearest to furthest
+     * @param max_radius Do not return entities further than this
+     * @return std::size_t The number of entities written to `out`
+     */
+    std::size_t query_nearest (const glm::vec3& center, std::span<serval::Neighbour> out, serval::Scalar max_radius=INFINITY) const {
+        if (out.empty() || m_sorted.empty()) {
+            return 0;
+        }
+        const auto max_radius_squared = max_radius * max_radius;
+        // Rings are in 64 bits and only walk the cells covering the indexed bounds, so a far away center neither overflows
+        // nor visits the empty rings between it and the index
+        const std::int64_t cx = far_cell_of(center.x);
+        const std::int64_t cy = far_cell_of(center.y);
+        const std::int64_t cz = far_cell_of(center.z);
+        const std::int64_t x0 = cell_of(m_bounds_min.x), x1 = cell_of(m_bounds_max.x);
+        const std::int64_t y0 = cell_of(m_bounds_min.y), y1 = cell_of(m_bounds_max.y);
+        const std::int64_t z0 = cell_of(m_bounds_min.z), z1 = cell_of(m_bounds_max.z);
+        // The nearest occupied cells are `first_ring` rings out, the furthest `last_ring`
+        const auto first_ring = std::max({x0 - cx, cx - x1, y0 - cy, cy - y1, z0 - cz, cz - z1, std::int64_t{0}});
+        auto last_ring = std::max({cx - x0, x1 - cx, cy - y0, y1 - cy, cz - z0, z1 - cz});
+        if (std::isfinite(max_radius)) {
+            last_ring = std::min(last_ring, std::int64_t(std::ceil(double(max_radius) * m_inverse_cell_size)) + 1);
+        }
+        std::size_t count = 0;
+        for (auto ring = first_ring; ring <= last_ring; ++ring) {
+            for (auto x = std::max(cx - ring, x0); x <= std::min(cx + ring, x1); ++x) {
+                for (auto y = std::max(cy - ring, y0); y <= std::min(cy + ring, y1); ++y) {
+                    // Only the shell of the cube is new in this ring
+                    const bool on_shell = x == cx - ring || x == cx + ring || y == cy - ring || y == cy + ring;
+                    const auto step = on_shell ? 1 : 2 * ring;
+                    for (auto z = on_shell ? std::max(cz - ring, z0) : cz - ring; z <= std::min(cz + ring, z1); z += step) {
+                        if (z < z0) {
+                            continue;
+                        }
+                        visit_cell(int(x), int(y), int(z), [&](const Entry& entry) {
+                            const auto offset = entry.position - center;
+                            const auto distance_squared = glm::dot(offset, offset);
+                            if (distance_squared > max_radius_squared || (count == out.size() && distance_squared >= out[count - 1].distance_squared)) {
+                                return true;
+                            }
+                            // Insert into the sorted results, dropping the furthest when full
+                            std::size_t index = count < out.size() ? count++ : count - 1;
+                            while (index > 0 && out[index - 1].distance_squared > distance_squared) {
+                                out[index] = out[index - 1];
+                                --index;
+                            }
+                            out[index] = {entry.entity, distance_squared};
+                            return true;
+                        });
+                    }
+                }
+            }
+            // Anything in further rings is at least `ring` cells away
+            const auto searched = serval::Scalar(ring) * m_cell_size;
+            if (count == out.size() && out[count - 1].distance_squared <= searched * searched) {
+                break;
+            }
+        }
+        return count;
+    }
+
+private:
+    struct Entry {
+        glm::vec3 position;
+        entt::entity entity;
+        std::uint32_t bucket;
+    };
+
+    // Only for positions of indexed entries or within the indexed bounds, see far_cell_of() for anything else
+    int cell_of (serval::Scalar value) const {
+        return int(std::floor(value * m_inverse_cell_size));
+    }
+
+    // As cell_of(), for query positions which may be arbitrarily far from the index
+    std::int64_t far_cell_of (serval::Scalar value) const {
+        constexpr double LIMIT = double(std::int64_t{1} << 40);
+        return std::int64_t(std::floor(std::clamp(double(value) * m_inverse_cell_size, -LIMIT, LIMIT)));
+    }
+
+    std::uint32_t bucket_of (int x, int y, int z) const {
+        return ((std::uint32_t(x) * 73856093u) ^ (std::uint32_t(y) * 19349663u) ^ (std::uint32_t(z) * 83492791u)) & m_bucket_mask;
+    }
+
+    void finalize () {
+        // Size the bucket table to keep the average bucket load below one
+        std::size_t buckets = 64;
+        while (buckets < m_entries.size() * 2) {
+            buckets <<= 1;
+        }
+        m_bucket_mask = std::uint32_t(buckets - 1);
+        m_bucket_start.assign(buckets + 1, 0);
+        m_bounds_min = glm::vec3{INFINITY};
+        m_bounds_max = glm::vec3{-INFINITY};
+        for (auto& entry : m_entries) {
+            entry.bucket = bucket_of(cell_of(entry.position.x), cell_of(entry.position.y), cell_of(entry.position.z));
+            ++m_bucket_start[entry.bucket + 1];
+            m_bounds_min = glm::min(m_bounds_min, entry.position);
+            m_bounds_max = glm::max(m_bounds_max, entry.position);
+        }
+        // Counting sort entries by bucket so that each bucket is a contiguous range
+        for (std::size_t i = 1; i <= buckets; ++i) {
+            m_bucket_start[i] += m_bucket_start[i - 1];
+        }
+        m_sorted.resize(m_entries.size());
+        m_cursor.assign(m_bucket_start.begin(), m_bucket_start.end() - 1);
+        for (const auto& entry : m_entries) {
+            m_sorted[m_cursor[entry.bucket]++] = entry;
+        }
+    }
+
+    // Call func for each entry in cell (x, y, z), stopping early if func returns false
+    template <typename Func>
+    bool visit_cell (int x, int y, int z, Func&& func) const {
+        const auto bucket = bucket_of(x, y, z);
+        for (auto i = m_bucket_start[bucket]; i < m_bucket_start[bucket + 1]; ++i) {
+            const auto& entry = m_sorted[i];
+            // Buckets are shared by colliding cells, skip entries which belong to another cell
+            if (cell_of(entry.position.x) != x || cell_of(entry.position.y) != y || cell_of(entry.position.z) != z) {
+                continue;
+            }
+            if (!func(entry)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Call func for each entry in the cells overlapping [min, max], stopping early if func returns false
+    template <typename Func>
+    bool for_each_cell (const glm::vec3& min, const glm::vec3& max, Func&& func) const {
+        if (m_sorted.empty()) {
+            return true;
+        }
+        // Clamp to the indexed bounds before converting to cells, so that huge queries neither walk empty cells nor overflow
+        const auto lo = glm::max(min, m_bounds_min);
+        const auto hi = glm::min(max, m_bounds_max);
+        if (!(lo.x <= hi.x && lo.y <= hi.y && lo.z <= hi.z)) {
+            return true;
+        }
+        const int x0 = cell_of(lo.x);
+        const int y0 = cell_of(lo.y);
+        const int z0 = cell_of(lo.z);
+        const int x1 = cell_of(hi.x);
+        const int y1 = cell_of(hi.y);
+        const int z1 = cell_of(hi.z);
+        for (int x = x0; x <= x1; ++x) {
+            for (int y = y0; y <= y1; ++y) {
+                for (int z = z0; z <= z1; ++z) {
+                    if (!visit_cell(x, y, z, func)) {
+                        return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    serval::Scalar m_cell_size;
+    serval::Scalar m_inverse_cell_size;
+    std::uint32_t m_bucket_mask = 0;
+    glm::vec3 m_bounds_min{0.0f};
+    glm::vec3 m_bounds_max{0.0f};
+    std::vector<Entry> m_entries;
+    std::vector<Entry> m_sorted;
+    std::vector<std::uint32_t> m_bucket_start;
+    std::vector<std::uint32_t> m_cursor;
+};
+
+#endif
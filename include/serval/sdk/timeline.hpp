@@ -58,6 +58,14 @@ public:
      * @return serval::Scalar 
      */
     virtual serval::Scalar absolute_scale () const = 0;
+
+    /**
+     * @brief How far the time not yet simulated is into the next fixed step, for blending the last two steps' snapshots
+     * Always 1 for timelines which aren't driven by a fixed-frequency scheduler (see serval::FixedStepClock)
+     * 
+     * @return serval::Scalar In [0, 1]
+     */
+    virtual serval::Scalar alpha () const = 0;
 };
 
 #endif
\ No newline at end of file
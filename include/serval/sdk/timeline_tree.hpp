@@ -0,0 +1,411 @@
+#ifndef SERVAL_SDK__TIMELINE_TREE_HPP
+#define SERVAL_SDK__TIMELINE_TREE_HPP
+
+#include "types.hpp"
+#include "timeline.hpp"
+
+#include <span>
+#include <vector>
+
+namespace serval {
+    class TimelineTree;
+
+    // A timeline in a TimelineTree, the generation tells a removed timeline apart from the one reusing its slot
+    struct TimelineId {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;  // 0 is never a live timeline
+
+        bool valid () const { return generation != 0; }
+        bool operator== (const TimelineId&) const = default;
+    };
+}
+
+/**
+ * @brief A tree of timelines stored in flat arrays, with every timeline's absolute scale and pause state cached
+ *
+ * Setting a timeline's scale, pausing it or moving it to another parent eagerly recomputes its whole subtree, which is
+ * O(subtree). In exchange every query is an inline array read: absolute_scale() doesn't walk the parents, and update()
+ * computes every timeline's delta in a single pass with no branches. This makes per-entity time dilation (a timeline
+ * per entity, parented to the bullet time zone it is in) cheap for tens of thousands of entities; read their deltas in
+ * bulk with deltas().
+ *
+ * delta() and elapsed() are in the timeline's own time, ie scaled by its absolute scale, and 0 while it or any of its
+ * parents is paused. view() adapts a timeline to the serval::Timeline interface.
+ *
+ * Timelines are identified by a slot index and a generation, like TimerId: slots of removed timelines are reused with a
+ * new generation, so mutators ignore ids of removed timelines rather than changing whichever timeline reused the slot.
+ * Queries index by slot without checking, check live() first if the id may be stale. ROOT is never removed.
+ *
+ * Not thread-safe: change the tree between frames or from a single task, reads are safe from any number of tasks while it
+ * isn't changing.
+ */
+class serval::TimelineTree {
+public:
+    using Id = serval::TimelineId;
+    static constexpr Id ROOT = {0, 1};
+    static constexpr Id NONE = {};
+
+    class View;
+
+    TimelineTree () {
+        allocate();
+        m_generation.back() = ROOT.generation;
+        m_live.back() = 1;
+        m_rate.back() = 1;
+    }
+
+    /**
+     * @brief Add a timeline
+     *
+     * @param parent The timeline to inherit scale and pause state from
+     * @param scale The timeline's local scale
+     * @return Id The new timeline, or NONE if parent was removed
+     */
+    Id create (Id parent=ROOT, serval::Scalar scale=1) {
+        if (!live(parent)) {
+            return NONE;
+        }
+        Index index;
+        if (m_free.empty()) {
+            index = allocate();
+        } else {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        m_live[index] = 1;
+        m_local_scale[index] = scale;
+        m_local_paused[index] = 0;
+        m_elapsed[index] = 0;
+        m_delta[index] = 0;
+        m_alpha[index] = 1;
+        link(index, parent.index);
+        propagate(index);
+        return {index, m_generation[index]};
+    }
+
+    /**
+     * @brief Remove a timeline, moving its children to its parent
+     *
+     * @param id Any timeline except the root
+     * @return true The timeline was removed
+     * @return false The id is the root, or the timeline was already removed
+     */
+    bool remove (Id id) {
+        if (id == ROOT || !live(id)) {
+            return false;
+        }
+        const auto index = id.index;
+        const auto parent = m_parent[index];
+        while (m_first_child[index] != NO_INDEX) {
+            const auto child = m_first_child[index];
+            unlink(child);
+            link(child, parent);
+            propagate(child);
+        }
+        unlink(index);
+        m_live[index] = 0;
+        m_rate[index] = 0;
+        m_delta[index] = 0;
+        m_generation[index] = m_generation[index] == ~std::uint32_t{0} ? 1 : m_generation[index] + 1;
+        m_free.push_back(index);
+        return true;
+    }
+
+    /**
+     * @brief Move a timeline (and its subtree) to a new parent, eg when an entity enters a bullet time zone
+     *
+     * @param id Any timeline except the root
+     * @param parent A timeline outside of id's subtree
+     * @return true The timeline was moved
+     * @return false The id is the root, either timeline was removed, or parent is in id's subtree (which would make a cycle)
+     */
+    bool set_parent (Id id, Id parent) {
+        if (id == ROOT || !live(id) || !live(parent)) {
+            return false;
+        }
+        for (auto ancestor = parent.index; ancestor != NO_INDEX; ancestor = m_parent[ancestor]) {
+            if (ancestor == id.index) {
+                return false;
+            }
+        }
+        unlink(id.index);
+        link(id.index, parent.index);
+        propagate(id.index);
+        return true;
+    }
+
+    /**
+     * @brief Set a timeline's local scale, updating the absolute scale of its subtree
+     *
+     * @param id
+     * @param scale
+     * @return true The scale was set
+     * @return false The timeline was removed
+     */
+    bool set_scale (Id id, serval::Scalar scale) {
+        if (!live(id)) {
+            return false;
+        }
+        m_local_scale[id.index] = scale;
+        propagate(id.index);
+        return true;
+    }
+
+    /**
+     * @brief Pause or resume a timeline, and with it its subtree
+     *
+     * @param id
+     * @param paused
+     * @return true The pause state was set
+     * @return false The timeline was removed
+     */
+    bool set_paused (Id id, bool paused) {
+        if (!live(id)) {
+            return false;
+        }
+        m_local_paused[id.index] = paused;
+        propagate(id.index);
+        return true;
+    }
+
+    /**
+     * @brief Set the fixed step blend factor reported through Timeline::alpha()
+     *
+     * @param id
+     * @param alpha
+     * @return true The blend factor was set
+     * @return false The timeline was removed
+     */
+    bool set_alpha (Id id, serval::Scalar alpha) {
+        if (!live(id)) {
+            return false;
+        }
+        m_alpha[id.index] = alpha;
+        return true;
+    }
+
+    /**
+     * @brief Advance every timeline by a frame
+     *
+     * @param frame_seconds The unscaled time since the last update
+     */
+    void update (serval::Scalar frame_seconds) {
+        m_frame_seconds = frame_seconds;
+        const auto count = m_rate.size();
+        const auto* rate = m_rate.data();
+        auto* delta = m_delta.data();
+        auto* elapsed = m_elapsed.data();
+        for (std::size_t id = 0; id < count; ++id) {
+            delta[id] = frame_seconds * rate[id];
+            elapsed[id] += delta[id];
+        }
+    }
+
+    bool live (Id id) const {
+        return id.index < m_live.size() && m_live[id.index] && m_generation[id.index] == id.generation;
+    }
+
+    /**
+     * @brief A timeline's parent
+     *
+     * @param id
+     * @return Id The parent, or NONE for the root
+     */
+    Id parent (Id id) const {
+        const auto parent = m_parent[id.index];
+        return parent == NO_INDEX ? NONE : Id{parent, m_generation[parent]};
+    }
+
+    bool paused (Id id) const {
+        return m_paused[id.index];
+    }
+
+    serval::Scalar local_scale (Id id) const {
+        return m_local_scale[id.index];
+    }
+
+    serval::Scalar absolute_scale (Id id) const {
+        return m_absolute_scale[id.index];
+    }
+
+    serval::Scalar delta (Id id) const {
+        return m_delta[id.index];
+    }
+
+    serval::Scalar elapsed (Id id) const {
+        return m_elapsed[id.index];
+    }
+
+    serval::Scalar alpha (Id id) const {
+        return m_alpha[id.index];
+    }
+
+    /**
+     * @brief The unscaled time passed to the last update()
+     *
+     * @return serval::Scalar
+     */
+    serval::Scalar frame_seconds () const {
+        return m_frame_seconds;
+    }
+
+    /**
+     * @brief Gather the deltas of many timelines
+     *
+     * @param ids
+     * @param out Must be at least as large as ids
+     */
+    void deltas (std::span<const Id> ids, std::span<serval::Scalar> out) const {
+        ASSERT(out.size() >= ids.size(), "Output span is too small");
+        const auto* delta = m_delta.data();
+        for (std::size_t index = 0; index < ids.size(); ++index) {
+            out[index] = delta[ids[index].index];
+        }
+    }
+
+    /**
+     * @brief Every timeline's delta, indexed by Id::index (removed timelines are 0)
+     *
+     * @return std::span<const serval::Scalar>
+     */
+    std::span<const serval::Scalar> deltas () const {
+        return m_delta;
+    }
+
+    View view (Id id) const;
+
+private:
+    // Links between timelines are plain slot indices, they are only followed between live timelines
+    using Index = std::uint32_t;
+    static constexpr Index NO_INDEX = ~Index{0};
+
+    Index allocate () {
+        m_parent.push_back(NO_INDEX);
+        m_first_child.push_back(NO_INDEX);
+        m_next_sibling.push_back(NO_INDEX);
+        m_prev_sibling.push_back(NO_INDEX);
+        m_local_scale.push_back(1);
+        m_absolute_scale.push_back(1);
+        m_rate.push_back(0);
+        m_delta.push_back(0);
+        m_elapsed.push_back(0);
+        m_alpha.push_back(1);
+        m_local_paused.push_back(0);
+        m_paused.push_back(0);
+        m_live.push_back(0);
+        m_generation.push_back(1);
+        return Index(m_parent.size() - 1);
+    }
+
+    void link (Index id, Index parent) {
+        m_parent[id] = parent;
+        m_prev_sibling[id] = NO_INDEX;
+        m_next_sibling[id] = m_first_child[parent];
+        if (m_first_child[parent] != NO_INDEX) {
+            m_prev_sibling[m_first_child[parent]] = id;
+        }
+        m_first_child[parent] = id;
+    }
+
+    void unlink (Index id) {
+        const auto parent = m_parent[id];
+        if (m_prev_sibling[id] != NO_INDEX) {
+            m_next_sibling[m_prev_sibling[id]] = m_next_sibling[id];
+        } else {
+            m_first_child[parent] = m_next_sibling[id];
+        }
+        if (m_next_sibling[id] != NO_INDEX) {
+            m_prev_sibling[m_next_sibling[id]] = m_prev_sibling[id];
+        }
+        m_parent[id] = NO_INDEX;
+    }
+
+    // Recompute the cached state of a timeline and its subtree from its parent
+    void propagate (Index id) {
+        m_stack.clear();
+        m_stack.push_back(id);
+        while (!m_stack.empty()) {
+            const auto node = m_stack.back();
+            m_stack.pop_back();
+            const auto parent = m_parent[node];
+            const bool parent_paused = parent != NO_INDEX && m_paused[parent];
+            const serval::Scalar parent_scale = parent != NO_INDEX ? m_absolute_scale[parent] : 1;
+            m_absolute_scale[node] = parent_scale * m_local_scale[node];
+            m_paused[node] = parent_paused || m_local_paused[node];
+            m_rate[node] = m_paused[node] ? 0 : m_absolute_scale[node];
+            for (auto child = m_first_child[node]; child != NO_INDEX; child = m_next_sibling[child]) {
+                m_stack.push_back(child);
+            }
+        }
+    }
+
+    serval::Scalar m_frame_seconds = 0;
+    std::vector<Index> m_parent;
+    std::vector<Index> m_first_child;
+    std::vector<Index> m_next_sibling;
+    std::vector<Index> m_prev_sibling;
+    std::vector<serval::Scalar> m_local_scale;
+    std::vector<serval::Scalar> m_absolute_scale;
+    std::vector<serval::Scalar> m_rate;  // absolute scale, or 0 while paused
+    std::vector<serval::Scalar> m_delta;
+    std::vector<serval::Scalar> m_elapsed;
+    std::vector<serval::Scalar> m_alpha;
+    std::vector<std::uint8_t> m_local_paused;
+    std::vector<std::uint8_t> m_paused;
+    std::vector<std::uint8_t> m_live;
+    std::vector<std::uint32_t> m_generation;
+    std::vector<Index> m_free;
+    std::vector<Index> m_stack;
+};
+
+/**
+ * @brief A timeline in a TimelineTree, as a serval::Timeline
+ * Following the Timeline interface, delta() is only scaled by the local scale. Prefer TimelineTree's own queries in
+ * hot loops, which aren't virtual.
+ */
+class serval::TimelineTree::View final : public serval::Timeline {
+public:
+    View (const serval::TimelineTree& tree, serval::TimelineTree::Id id) : m_tree(&tree), m_id(id) {}
+
+    serval::TimelineTree::Id id () const {
+        return m_id;
+    }
+
+    bool paused () const override {
+        return m_tree->paused(m_id);
+    }
+
+    serval::Scalar elapsed () const override {
+        return m_tree->elapsed(m_id);
+    }
+
+    serval::Scalar scale (serval::Scalar time) const override {
+        return time * m_tree->local_scale(m_id);
+    }
+
+    serval::Scalar delta () const override {
+        return m_tree->paused(m_id) ? 0 : m_tree->frame_seconds() * m_tree->local_scale(m_id);
+    }
+
+    serval::Scalar local_scale () const override {
+        return m_tree->local_scale(m_id);
+    }
+
+    serval::Scalar absolute_scale () const override {
+        return m_tree->absolute_scale(m_id);
+    }
+
+    serval::Scalar alpha () const override {
+        return m_tree->alpha(m_id);
+    }
+
+private:
+    const serval::TimelineTree* m_tree;
+    serval::TimelineTree::Id m_id;
+};
+
+inline serval::TimelineTree::View serval::TimelineTree::view (Id id) const {
+    return {*this, id};
+}
+
+#endif
@@ -0,0 +1,477 @@
+#ifndef SERVAL_SDK__TIMERS_HPP
+#define SERVAL_SDK__TIMERS_HPP
+
+#include "types.hpp"
+#include "api.hpp"
+#include "timeline.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace serval {
+    class TimerWheel;
+
+    struct TimerId {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0;  // 0 is never a live timer
+
+        bool valid () const { return generation != 0; }
+    };
+}
+
+/**
+ * @brief Hierarchical timer wheel for delayed callbacks, commands and actor messages, driven by a Timeline
+ *
+ * Time is counted in ticks of `resolution` seconds of the timeline's (scaled) time. The wheel has four levels of 256
+ * slots: level 0 holds timers due in the next 256 ticks, one slot per tick, and each level above covers 256 times the
+ * range of the one below. When the lower level wraps, the next slot of the level above is cascaded down. Scheduling and
+ * cancelling are O(1) (a pool allocation and a linked list insert or unlink), pending timers cost nothing per frame, and
+ * advancing skips straight over empty stretches of time.
+ *
+ * Timers never fire from schedule*() or advance(). Timers due by the end of advance() are collected into a batch, and
+ * fire() runs the batch in expiry order (ties in scheduling order). The engine advances and fires each scheduler's wheel
+ * at the start of the scheduler's frame, before any of its tasks run (see Runtime::timers()).
+ *
+ * Scheduling and cancelling are thread-safe; advance() and fire() are called by one thread.
+ */
+class serval::TimerWheel {
+public:
+    static constexpr std::uint32_t SLOT_BITS = 8;
+    static constexpr std::uint32_t SLOTS = 1 << SLOT_BITS;
+    static constexpr std::uint32_t LEVELS = 4;
+    static constexpr std::size_t PAYLOAD_SIZE = 48;
+
+    /**
+     * @param resolution Seconds per tick, delays are rounded up to a whole number of ticks
+     */
+    explicit TimerWheel (double resolution=0.001) : m_resolution(resolution) {
+        m_heads.fill(NONE);
+    }
+    TimerWheel (const TimerWheel&) = delete;
+    TimerWheel& operator= (const TimerWheel&) = delete;
+
+    /**
+     * @brief Call a function after a delay
+     *
+     * @param delay Seconds of timeline time
+     * @param callback
+     * @return serval::TimerId
+     */
+    serval::TimerId schedule (serval::Scalar delay, serval::Callback callback) {
+        return insert(delay, [](serval::Runtime&, const std::byte* payload){
+            std::get<0>(load<serval::Callback>(payload))();
+        }, callback);
+    }
+
+    /**
+     * @brief Send a simple tag/argument command after a delay, see Runtime::command()
+     *
+     * @param delay Seconds of timeline time
+     * @param target The id of the target to send the command to
+     * @param command_id The id of the command to send
+     * @param argument The hashed_string id to send as the argument
+     * @return serval::TimerId
+     */
+    serval::TimerId scheduleCommand (serval::Scalar delay, serval::Id target, serval::Id command_id, serval::Id argument) {
+        return insert(delay, [](serval::Runtime& api, const std::byte* payload){
+            const auto [target, command_id, argument] = load<serval::Id, serval::Id, serval::Id>(payload);
+            api.command(target, command_id, argument);
+        }, target, command_id, argument);
+    }
+
+    /**
+     * @brief Send a message to an actor after a delay, see Runtime::message()
+     *
+     * @tparam Params
+     * @param delay Seconds of timeline time
+     * @param target_actor The actor to send the message to
+     * @param message The hashed string message type
+     * @param params Zero to Five arguments of types supported by variant::Type
+     * @return serval::TimerId
+     */
+    template <typename... Params>
+    serval::TimerId scheduleMessage (serval::Scalar delay, entt::entity target_actor, serval::Id message, Params... params) {
+        static_assert(sizeof...(params) <= 5, "Maximum of 5 parameters supported by messages");
+        return insert(delay, [](serval::Runtime& api, const std::byte* payload){
+            std::apply([&api](auto... args){ api.message(args...); }, load<entt::entity, serval::Id, Params...>(payload));
+        }, target_actor, message, params...);
+    }
+
+    /**
+     * @brief Cancel a pending timer
+     *
+     * @param timer
+     * @return true The timer was pending and will not fire
+     * @return false The timer had already fired or been cancelled
+     */
+    bool cancel (serval::TimerId timer) {
+        std::scoped_lock lock{m_mutex};
+        if (timer.index >= m_nodes.size() || m_nodes[timer.index].generation != timer.generation) {
+            return false;
+        }
+        auto& node = m_nodes[timer.index];
+        if (node.slot == DUE) {
+            // Already in the batch for fire(), which skips released nodes
+            node.generation = next_generation(node.generation);
+            node.slot = FREE;
+            --m_due_count;
+        } else {
+            unlink(timer.index);
+            release(timer.index);
+            --m_count;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Check if a timer is still waiting to fire
+     *
+     * @param timer
+     * @return true
+     * @return false
+     */
+    bool pending (serval::TimerId timer) const {
+        std::scoped_lock lock{m_mutex};
+        return timer.index < m_nodes.size() && m_nodes[timer.index].generation == timer.generation;
+    }
+
+    /**
+     * @brief Advance by the timeline's last delta, at its absolute scale, unless it is paused
+     *
+     * @param timeline
+     */
+    void advance (const serval::Timeline& timeline) {
+        if (timeline.paused()) {
+            return;
+        }
+        // delta() only includes the timeline's own scale, apply its parents' too
+        const auto local = timeline.local_scale();
+        advance(local != 0 ? timeline.delta() * (timeline.absolute_scale() / local) : 0);
+    }
+
+    /**
+     * @brief Advance by a number of seconds, collecting the timers which are now due for fire()
+     *
+     * @param seconds
+     */
+    void advance (double seconds) {
+        // Time never runs backwards, and a NaN would poison the remainder for good
+        if (!(seconds > 0)) {
+            return;
+        }
+        std::scoped_lock lock{m_mutex};
+        m_remainder += std::min(seconds / m_resolution, MAX_TICKS);
+        // Tolerate rounding in seconds / resolution, eg 0.007 / 0.001 = 6.999..., rather than lag a tick behind
+        const auto ticks = std::floor(m_remainder + 1e-6);
+        m_remainder -= ticks;
+        const auto target = m_now + std::uint64_t(ticks);
+        while (m_now < target) {
+            if (m_count == 0) {
+                m_now = target;
+                break;
+            }
+            const auto tick = m_now + 1;
+            // With the bottom levels empty, nothing happens until the next cascade from the first occupied level
+            std::uint32_t empty = 0;
+            while (m_level_counts[empty] == 0) {
+                ++empty;
+            }
+            const auto until_cascade = (std::uint64_t{1} << (SLOT_BITS * empty)) - 1;
+            if ((tick & until_cascade) != 0) {
+                m_now = std::min(target, tick | until_cascade);
+                continue;
+            }
+            m_now = tick;
+            for (auto level = LEVELS - 1; level > 0; --level) {
+                if ((tick & ((std::uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0) {
+                    cascade(level, std::uint32_t(tick >> (SLOT_BITS * level)) & (SLOTS - 1));
+                }
+            }
+            collect(head(0, std::uint32_t(tick) & (SLOTS - 1)));
+        }
+    }
+
+    /**
+     * @brief Run the timers collected by advance()
+     *
+     * @param api The runtime to send commands and messages through
+     * @return std::size_t The number of timers run
+     */
+    std::size_t fire (serval::Runtime& api) {
+        {
+            std::scoped_lock lock{m_mutex};
+            std::swap(m_due, m_firing);
+        }
+        std::size_t fired = 0;
+        for (const auto index : m_firing) {
+            Payload payload;
+            FireFn fn;
+            {
+                std::scoped_lock lock{m_mutex};
+                auto& node = m_nodes[index];
+                fn = node.slot == DUE ? node.fire : nullptr;
+                payload = node.payload;
+                if (node.slot == DUE) {
+                    release(index);
+                    --m_due_count;
+                } else {
+                    // Cancelled while due, the generation was already bumped
+                    node.slot = IDLE;
+                    m_free.push_back(index);
+                }
+            }
+            if (fn) {
+                fn(api, payload.data);
+                ++fired;
+            }
+        }
+        std::scoped_lock lock{m_mutex};
+        m_firing.clear();
+        return fired;
+    }
+
+    /**
+     * @brief Advance by the timeline and run the timers which became due
+     *
+     * @param timeline
+     * @param api
+     * @return std::size_t The number of timers run
+     */
+    std::size_t update (const serval::Timeline& timeline, serval::Runtime& api) {
+        advance(timeline);
+        return fire(api);
+    }
+
+    /**
+     * @brief The number of timers waiting to fire
+     *
+     * @return std::size_t
+     */
+    std::size_t size () const {
+        std::scoped_lock lock{m_mutex};
+        return m_count + m_due_count;
+    }
+
+    /**
+     * @brief Cancel every pending timer
+     * Safe to call from a timer, the rest of the batch being fired is cancelled too
+     *
+     */
+    void clear () {
+        std::scoped_lock lock{m_mutex};
+        for (std::uint32_t index = 0; index < m_nodes.size(); ++index) {
+            if (m_nodes[index].slot < DUE) {
+                unlink(index);
+                release(index);
+            }
+        }
+        for (const auto index : m_due) {
+            release(index);
+        }
+        m_due.clear();
+        // Called from a timer, the rest of the batch fire() is running is still due: cancel it like cancel() does
+        for (const auto index : m_firing) {
+            auto& node = m_nodes[index];
+            if (node.slot == DUE) {
+                node.generation = next_generation(node.generation);
+                node.slot = FREE;
+            }
+        }
+        m_count = 0;
+        m_due_count = 0;
+    }
+
+private:
+    using Index = std::uint32_t;
+    using FireFn = void(*)(serval::Runtime&, const std::byte*);
+
+    static constexpr Index NONE = ~Index{0};
+    // Node::slot is the list it is in: level * SLOTS + slot, or one of these
+    static constexpr std::uint32_t DUE = LEVELS * SLOTS;  // Collected by advance(), waiting for fire()
+    static constexpr std::uint32_t FREE = DUE + 1;        // Cancelled while due, released by fire()
+    static constexpr std::uint32_t IDLE = DUE + 2;        // On the free list
+    // Longest delay or advance, in ticks: exact as a double, and converts to the tick counter without overflowing it
+    static constexpr double MAX_TICKS = double(std::uint64_t{1} << 53);
+
+    struct alignas(16) Payload {
+        std::byte data[PAYLOAD_SIZE];
+    };
+
+    struct Node {
+        Payload payload;
+        FireFn fire;
+        std::uint64_t expires;
+        std::uint64_t sequence;  // Scheduling order, for ties
+        Index prev;
+        Index next;
+        std::uint32_t generation;
+        std::uint32_t slot;
+    };
+
+    // Timer parameters are packed into the node's payload one after another, each at its natural alignment
+    template <typename... Ts>
+    static constexpr std::size_t packed_size () {
+        std::size_t size = 0;
+        ((size = ((size + alignof(Ts) - 1) & ~(alignof(Ts) - 1)) + sizeof(Ts)), ...);
+        return size;
+    }
+
+    template <typename T>
+    static void store (std::byte* payload, std::size_t& offset, const T& value) {
+        offset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+        std::memcpy(payload + offset, &value, sizeof(T));
+        offset += sizeof(T);
+    }
+
+    template <typename T>
+    static T read (const std::byte* payload, std::size_t& offset) {
+        offset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+        T value;
+        std::memcpy(&value, payload + offset, sizeof(T));
+        offset += sizeof(T);
+        return value;
+    }
+
+    template <typename... Ts>
+    static std::tuple<Ts...> load (const std::byte* payload) {
+        std::size_t offset = 0;
+        // Braced initialisation evaluates the reads in order
+        return std::tuple<Ts...>{read<Ts>(payload, offset)...};
+    }
+
+    static std::uint32_t next_generation (std::uint32_t generation) {
+        return generation == ~std::uint32_t{0} ? 1 : generation + 1;
+    }
+
+    template <typename... Ts>
+    serval::TimerId insert (serval::Scalar delay, FireFn fn, const Ts&... values) {
+        static_assert((std::is_trivially_copyable_v<Ts> && ...), "Timer parameters must be trivially copyable");
+        static_assert(packed_size<Ts...>() <= PAYLOAD_SIZE && ((alignof(Ts) <= 16) && ...), "Timer parameters are too large");
+        // Negative and NaN delays fire on the next tick, longer ones than MAX_TICKS wait at the top level like any far timer
+        const auto ticks = std::min(std::max(1.0, std::ceil(double(delay) / m_resolution)), MAX_TICKS);
+
+        std::scoped_lock lock{m_mutex};
+        Index index;
+        if (m_free.empty()) {
+            index = Index(m_nodes.size());
+            m_nodes.emplace_back();
+        } else {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        auto& node = m_nodes[index];
+        std::size_t offset = 0;
+        (store(node.payload.data, offset, values), ...);
+        node.fire = fn;
+        node.expires = m_now + std::uint64_t(ticks);
+        node.sequence = m_sequence++;
+        node.generation = next_generation(node.generation);
+        link(index);
+        ++m_count;
+        return {index, node.generation};
+    }
+
+    // Put a node in the lowest level whose range covers the time left until it expires. A level L slot is cascaded at the
+    // first tick of its span of SLOTS^L ticks, which is never after the expiry of a timer placed in it, so the timer is
+    // re-linked into a lower level in time.
+    void link (Index index) {
+        auto& node = m_nodes[index];
+        // Beyond the wheel's range: park it in the furthest top level slot, which re-links it with the time left
+        constexpr auto RANGE = std::uint64_t{1} << (SLOT_BITS * LEVELS);
+        const auto expires = std::min(node.expires, m_now + RANGE - 1);
+        const auto remaining = expires - m_now;
+        std::uint32_t level = 0;
+        while (level < LEVELS - 1 && remaining >= (std::uint64_t{1} << (SLOT_BITS * (level + 1)))) {
+            ++level;
+        }
+        node.slot = level * SLOTS + (std::uint32_t(expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+        node.prev = NONE;
+        node.next = m_heads[node.slot];
+        if (node.next != NONE) {
+            m_nodes[node.next].prev = index;
+        }
+        m_heads[node.slot] = index;
+        ++m_level_counts[level];
+    }
+
+    void unlink (Index index) {
+        auto& node = m_nodes[index];
+        if (node.prev != NONE) {
+            m_nodes[node.prev].next = node.next;
+        } else {
+            m_heads[node.slot] = node.next;
+        }
+        if (node.next != NONE) {
+            m_nodes[node.next].prev = node.prev;
+        }
+        --m_level_counts[node.slot / SLOTS];
+    }
+
+    void release (Index index) {
+        auto& node = m_nodes[index];
+        node.generation = next_generation(node.generation);
+        node.slot = IDLE;
+        m_free.push_back(index);
+    }
+
+    Index& head (std::uint32_t level, std::uint32_t slot) {
+        return m_heads[level * SLOTS + slot];
+    }
+
+    Index take (std::uint32_t level, std::uint32_t slot) {
+        auto& list = head(level, slot);
+        const auto first = list;
+        list = NONE;
+        for (auto index = first; index != NONE; index = m_nodes[index].next) {
+            --m_level_counts[level];
+        }
+        return first;
+    }
+
+    void cascade (std::uint32_t level, std::uint32_t slot) {
+        for (auto index = take(level, slot); index != NONE;) {
+            const auto next = m_nodes[index].next;
+            link(index);
+            index = next;
+        }
+    }
+
+    // Move a level 0 slot, whose timers all expire on this tick, to the due batch. Timers arrive in the slot both directly
+    // and by cascades from higher levels, so restore scheduling order.
+    void collect (Index& list) {
+        const auto start = m_due.size();
+        for (auto index = list; index != NONE; index = m_nodes[index].next) {
+            m_nodes[index].slot = DUE;
+            m_due.push_back(index);
+            --m_level_counts[0];
+            --m_count;
+            ++m_due_count;
+        }
+        list = NONE;
+        std::sort(m_due.begin() + std::ptrdiff_t(start), m_due.end(), [this](Index a, Index b){
+            return m_nodes[a].sequence < m_nodes[b].sequence;
+        });
+    }
+
+    double m_resolution;
+    double m_remainder = 0;
+    std::uint64_t m_now = 0;
+    std::uint64_t m_sequence = 0;
+    std::size_t m_count = 0;      // Linked into the wheel
+    std::size_t m_due_count = 0;  // In the due batch and not cancelled
+    std::array<std::size_t, LEVELS> m_level_counts{};
+    std::array<Index, LEVELS * SLOTS> m_heads;
+    std::vector<Node> m_nodes;
+    std::vector<Index> m_free;
+    std::vector<Index> m_due;
+    std::vector<Index> m_firing;
+    mutable std::mutex m_mutex;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define SERVAL_SDK__TYPE_UTILS_HPP
 
 #include <type_traits>
+#include <entt/core/type_info.hpp>
 
 namespace serval {
     template <typename T> struct class_of;
@@ -16,6 +17,11 @@ namespace serval {
     template <typename T>
     struct is_resource<T, std::void_t<decltype(std::declval<T>().ResourceTypeID)>> : std::true_type {};
 
+    template <typename, typename = std::void_t<>>
+    struct is_asset : std::false_type {};
+    template <typename T>
+    struct is_asset<T, std::void_t<decltype(std::declval<T>().AssetTypeId)>> : std::true_type {};
+
     template <typename, typename = std::void_t<>>
     struct is_component : std::false_type {};
     template <typename T>
@@ -29,11 +35,25 @@ namespace serval {
     template <typename T>
     constexpr bool is_resource_v = is_resource<T>::value;
 
+    template <typename T>
+    constexpr bool is_asset_v = is_asset<T>::value;
+
     template <typename T>
     constexpr bool is_component_v = is_component<T>::value;
 
     template <typename T>
     constexpr bool is_system_v = is_system<T>::value;
+
+    /**
+     * @brief Get the id used by the engine to identify a component storage
+     * 
+     * @tparam Component 
+     * @return entt::id_type 
+     */
+    template <typename Component>
+    constexpr entt::id_type component_type_id () {
+        return entt::type_hash<std::remove_cv_t<Component>>::value();
+    }
 }
 
 #endif
\ No newline at end of file
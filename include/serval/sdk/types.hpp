@@ -5,6 +5,7 @@
 
 // From std::
 #include <cstdint>
+#include <string>
 
 // From third-party dependencies
 #include <entt/entity/entity.hpp>
@@ -77,6 +78,42 @@ namespace serval {
 
     enum class Handle : std::uint32_t {};
 
+    /**
+     * @brief Encoding of serval::Handle
+     * A handle packs the index of a resource slot (low 20 bits) with the generation of that slot (high 12 bits).
+     * Generations start at 1 and are bumped with next_generation() whenever a slot is freed, so stale handles fail to resolve
+     * and 0 is never a valid handle. Generations are 12 bits even where they are stored wider (eg ResourceSlots::generations)
+     * and wrap from 4095 back to 1, so a stored generation always compares equal to the one in its handles.
+     *
+     */
+    namespace handles {
+        static constexpr std::uint32_t INDEX_BITS = 20;
+        static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+        static constexpr std::uint32_t GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+        constexpr Handle make (std::uint32_t index, std::uint32_t generation) {
+            return static_cast<Handle>(((generation & GENERATION_MASK) << INDEX_BITS) | (index & INDEX_MASK));
+        }
+
+        constexpr std::uint32_t index (Handle handle) {
+            return static_cast<std::uint32_t>(handle) & INDEX_MASK;
+        }
+
+        constexpr std::uint32_t generation (Handle handle) {
+            return static_cast<std::uint32_t>(handle) >> INDEX_BITS;
+        }
+
+        /**
+         * @brief The generation a slot moves to when it is freed, skipping 0
+         *
+         * @param generation The slot's current generation
+         * @return std::uint32_t In [1, GENERATION_MASK]
+         */
+        constexpr std::uint32_t next_generation (std::uint32_t generation) {
+            return (generation % GENERATION_MASK) + 1;
+        }
+    }
+
     enum class ContainerType : std::uint8_t {
         Invalid   = 0b00,
         EnittySet = 0b01,
@@ -111,7 +148,7 @@ namespace serval {
                 return DataType::Entity;
             } else if (container == ContainerType::List) {
                 const auto type = static_cast<DataType>((m_packed_data >> 26) & 0x7);
-                if ((type == DataType::Container | type == DataType::Handle | type == DataType::Invalid) == 0) {
+                if (type != DataType::Container && type != DataType::Handle && type != DataType::Invalid) {
                     return type;
                 }
             }
@@ -139,6 +176,9 @@ namespace serval {
 
     template <typename Type> struct WrapPtr { Type* ptr; };
 
+    // Change tracking, 64 bits since the version advances for every task run and must never wrap
+    using Version = std::uint64_t;
+
     // IO types
     class Reader;
     class Writer;
@@ -155,22 +195,35 @@ namespace serval {
     class Timeline;
 
     // Factory functions
+    // The engine allocates `size` bytes aligned to `alignment`, constructs the object with fn() and destroys it with destroy()
+    // destroy() returns the start of the block to free, which differs from the Class* when Class isn't Derived's first base
     template <typename Class>
     struct FactoryFn {
         std::size_t size;
+        std::size_t alignment;
         Class*(*fn)(void*);
+        void*(*destroy)(Class*);
         Class* operator()(void* vp) const {
             return fn(vp);
         }
     };
     static_assert(std::is_trivial_v<FactoryFn<int>>, "FactoryFn<T> must be trivial");
-    static_assert(std::is_trivial_v<FactoryFn<int>>, "FactoryFn<T> must be standard layout");
+    static_assert(std::is_standard_layout_v<FactoryFn<int>>, "FactoryFn<T> must be standard layout");
     template <typename Derived>
     struct makeFactoryFn {
         template <typename Class>
         operator FactoryFn<Class>() const {
             static_assert(std::is_base_of<Class, Derived>::value);
-            return FactoryFn<Class>{ sizeof(Derived), +[](void* ptr) -> Class* { return new(ptr) Derived; } };
+            return FactoryFn<Class>{
+                sizeof(Derived),
+                alignof(Derived),
+                +[](void* ptr) -> Class* { return new(ptr) Derived; },
+                +[](Class* ptr) -> void* {
+                    auto* object = static_cast<Derived*>(ptr);
+                    object->~Derived();
+                    return object;
+                },
+            };
         }
     };
 
@@ -19,15 +19,15 @@ namespace serval::variant {
     
     using Container = std::variant<std::uint8_t, bool, std::int32_t, std::int64_t, serval::Scalar, entt::entity, serval::Id, glm::vec2, glm::vec3, glm::vec4, glm::quat, serval::ContainerHandle, serval::Handle, Invalid>;
 
-    static constexpr TypeId to_id (Type type) {
+    inline constexpr TypeId to_id (Type type) {
         return static_cast<TypeId>(type);
     }
 
-    static constexpr Type from_id (TypeId type_id) {
+    inline constexpr Type from_id (TypeId type_id) {
         return static_cast<Type>(type_id);
     }
 
-    struct detail {
+    namespace detail {
         template <Type> struct TypeOf { using Type = void; };
         template <> struct TypeOf<Type::Byte> { using Type = std::uint8_t; };
         template <> struct TypeOf<Type::Boolean> { using Type = bool; };
@@ -42,7 +42,7 @@ namespace serval::variant {
         template <> struct TypeOf<Type::Rotation> { using Type = glm::quat; };
         template <> struct TypeOf<Type::Container> { using Type = serval::ContainerHandle; };
         template <> struct TypeOf<Type::Handle> { using Type = serval::Handle; };
-    };
+    }
 
     /**
      * @brief Convert a Type enum into a C++ type
@@ -52,14 +52,14 @@ namespace serval::variant {
     template <Type T>
     using TypeOf = typename detail::TypeOf<T>::Type;
 
-    template <Type T> static constexpr std::size_t size () {
+    template <Type T> inline constexpr std::size_t size () {
         if constexpr (T == Type::Invalid) {
             return 0;
         } else {
             return sizeof(TypeOf<T>);
         }
     }
-    static constexpr std::size_t size (Type type) {
+    inline constexpr std::size_t size (Type type) {
         switch (type) {
             case Type::Byte: return size<Type::Byte>();
             case Type::Boolean: return size<Type::Boolean>();
@@ -84,7 +84,7 @@ namespace serval::variant {
      * @tparam T Native type
      * @return constexpr Type The enum type value that most closely matches the native type 
      */
-    template <typename T> static constexpr Type type_of () {
+    template <typename T> inline constexpr Type type_of () {
         if constexpr (std::is_same_v<T, bool>) {
             return Type::Boolean;
         } else if constexpr (std::is_same_v<T, std::uint8_t>  || std::is_same_v<T, std::byte>) {
@@ -98,7 +98,7 @@ namespace serval::variant {
         } else if constexpr (std::is_same_v<T, entt::entity>) {
             return Type::Entity;
         } else if constexpr (std::is_same_v<T, serval::Id>) {
-            return Type::HashId;
+            return Type::Id;
         } else if constexpr (std::is_same_v<T, glm::vec2>) {
             return Type::Vec2;
         } else if constexpr (std::is_same_v<T, glm::vec3>) {
@@ -115,7 +115,7 @@ namespace serval::variant {
             return Type::Invalid;
         }
     }
-    template <typename T> static constexpr Type type_of (T) {
+    template <typename T> inline constexpr Type type_of (T) {
         return type_of<T>();
     }
 
@@ -132,7 +132,7 @@ namespace serval::variant {
      * @param value 
      * @return constexpr Type 
      */
-    static constexpr Type type_of (const Container& value) {
+    inline constexpr Type type_of (const Container& value) {
         return std::visit(
             [](const auto& underlying) {
                 return type_of<std::decay_t<decltype(underlying)>>();
@@ -146,7 +146,7 @@ namespace serval::variant {
      * @param value 
      * @return constexpr Type 
      */
-    static constexpr Type type_of (const std::optional<Container>& optional) {
+    inline constexpr Type type_of (const std::optional<Container>& optional) {
         if (optional.has_value()) {
             return std::visit(
                 [](const auto& underlying) {
@@ -166,7 +166,7 @@ namespace serval::variant {
      * @param ptr 
      * @return T
      */
-    template <typename T> static T cast (const void* ptr) {
+    template <typename T> inline T cast (const void* ptr) {
         constexpr auto TypeValue = type_of<T>(); 
         static_assert(TypeValue != Type::Invalid, "Tried to convert void* to value with unsupported type");
         return T{*reinterpret_cast<const TypeOf<TypeValue>*>(ptr)};
@@ -179,7 +179,7 @@ namespace serval::variant {
      * @param ptr 
      * @return TypeOf<T>* 
      */
-    template <Type T> static TypeOf<T>* ptr_cast (const void* ptr) {
+    template <Type T> inline TypeOf<T>* ptr_cast (const void* ptr) {
         static_assert(T != Type::Invalid, "Tried to convert void* to invalid type");
         return reinterpret_cast<const TypeOf<T>*>(ptr);
     }
@@ -191,7 +191,7 @@ namespace serval::variant {
      * @param ptr 
      * @return Container 
      */
-    static Container cast (Type type, const void* const ptr) {
+    inline Container cast (Type type, const void* const ptr) {
         switch (type) {
             case Type::Byte: return {cast<TypeOf<Type::Byte>>(ptr)};
             case Type::Boolean: return {cast<TypeOf<Type::Boolean>>(ptr)};
@@ -216,7 +216,7 @@ namespace serval::variant {
      * @param value 
      * @return const void* 
      */
-    static const void* ptr (const Container& value) {
+    inline const void* ptr (const Container& value) {
         return std::visit(
             [](const auto& underlying) -> const void* {
                 using T = std::decay_t<decltype(underlying)>;
@@ -229,7 +229,7 @@ namespace serval::variant {
         );
     }
 
-    static bool copy_into (const Container& source, Type destination_type, void* destination) {
+    inline bool copy_into (const Container& source, Type destination_type, void* destination) {
         return std::visit(
             [destination_type, destination](const auto& underlying) {
                 using T = std::decay_t<decltype(underlying)>;
@@ -255,7 +255,7 @@ namespace serval::variant {
      * @return true The variant contains a valid value
      * @return false The variant contains a value of type Type::Invalid
      */
-    static bool is_valid (const Container& value) {
+    inline bool is_valid (const Container& value) {
         return !std::holds_alternative<serval::variant::Invalid>(value);
     }
     /**
@@ -265,7 +265,7 @@ namespace serval::variant {
      * @return true The variant contains a value of type Type::Invalid
      * @return false The variant contains a valid value
      */
-    static bool is_invalid (const Container& value) {
+    inline bool is_invalid (const Container& value) {
         return std::holds_alternative<serval::variant::Invalid>(value);
     }
 }
@@ -7,5 +7,9 @@
 #include "sdk/variant.hpp"
 #include "sdk/api.hpp"
 #include "sdk/timeline.hpp"
+#include "sdk/timeline_tree.hpp"
+#include "sdk/timers.hpp"
+#include "sdk/spatial.hpp"
+#include "sdk/serialization.hpp"
 
 #endif
\ No newline at end of file
@@ -9,8 +9,8 @@
  * Plugin entrypoint and setup
  ********************************************************************************/
 
+// NOTE: Statics are not carried across a reload, the engine tracks reload state and owns any state which must persist
 static serval::Init* engine_api = nullptr;
-static bool is_reloading = false;
 
 CR_EXPORT int cr_main(cr_plugin* ctx, cr_op operation)
 {
@@ -18,20 +18,22 @@ CR_EXPORT int cr_main(cr_plugin* ctx, cr_op operation)
         auto init = static_cast<serval::ExtensionInit*>(ctx->userdata);
         // Set spdlog logger
         spdlog::set_default_logger(init->logger);
+        serval::log::set_backend(init->log_backend);
         // Set Dear ImGUI context
         ImGui::SetCurrentContext(init->imgui_context);
         // Store the engine API for later use
         engine_api = init->engine_init_api;
-        // First load is never a reload
-        is_reloading = false;
     }
     switch (operation) {
         // Hot-code reloading
         case CR_LOAD:
         {
-            if (is_reloading) {
-                is_reloading = false;
+            if (engine_api->reloading()) {
+                // Registrations made by the reload are diffed against the previous ones, so only changes are re-created
                 serval_extension_reload(*engine_api);
+                const auto stats = engine_api->endReload();
+                spdlog::info("Extension reloaded in {:.2f}ms ({} tasks rebound, {} added, {} removed, {} states preserved, {} reset)",
+                    stats.milliseconds, stats.tasks_rebound, stats.tasks_added, stats.tasks_removed, stats.states_preserved, stats.states_reset);
             } else {
                 serval_extension_load(*engine_api);
             }
@@ -39,7 +41,11 @@ CR_EXPORT int cr_main(cr_plugin* ctx, cr_op operation)
         }
         case CR_UNLOAD:
         {
-            is_reloading = true;
+            // Pending log records point at call sites in this module, format them before it is unloaded
+            if (auto* backend = serval::log::backend()) {
+                backend->drain();
+            }
+            engine_api->beginReload();
             break;
         }
         // Update step
@@ -51,6 +57,9 @@ CR_EXPORT int cr_main(cr_plugin* ctx, cr_op operation)
         case CR_CLOSE:
         {
             serval_extension_unload(*engine_api);
+            if (auto* backend = serval::log::backend()) {
+                backend->drain();
+            }
             break;
         }
     }
@@ -0,0 +1,20 @@
+#ifndef SERVAL_TESTS__CHECK_HPP
+#define SERVAL_TESTS__CHECK_HPP
+
+#include <cstdio>
+
+/********************************************************************************
+ * Minimal checks for the SDK tests: a failed CHECK reports itself and the test
+ * exits with a non-zero status, which ctest counts as a failure
+ ********************************************************************************/
+
+namespace serval::tests {
+    inline int& failures () {
+        static int count = 0;
+        return count;
+    }
+}
+
+#define CHECK(condition) {if (!(condition)) {std::fprintf(stderr, "%s:%d Check failed: %s\n", __FILE__, __LINE__, #condition); ++serval::tests::failures();}}
+
+#endif
@@ -0,0 +1,52 @@
+#include "check.hpp"
+
+#include <serval/sdk/fixed_step.hpp>
+
+#include <cstdint>
+#include <limits>
+
+namespace {
+    using Position = components::core::Position;
+
+    // Negative, NaN, huge and infinite frame times run between 0 and max_steps steps, never an overflowed count
+    void clock_range () {
+        serval::FixedStepClock clock{0.01f, 5};
+        CHECK(clock.advance(-1.0f) == 0);
+        CHECK(clock.advance(std::numeric_limits<float>::quiet_NaN()) == 0);
+        CHECK(clock.alpha() == 0);
+        CHECK(clock.advance(0.025f) == 2);
+        CHECK(clock.advance(1e30f) == 5);
+        CHECK(clock.alpha() == 0);
+        CHECK(clock.advance(std::numeric_limits<float>::infinity()) == 5);
+        CHECK(clock.advance(0.0f) == 0);
+        CHECK(clock.ticks() == 12);
+
+        serval::FixedStepClock unbounded{1.0f, std::numeric_limits<std::uint32_t>::max()};
+        CHECK(unbounded.advance(1e30f) == std::numeric_limits<std::uint32_t>::max());
+    }
+
+    // A recycled entity number with a new version neither blends from nor reads the destroyed entity's snapshots
+    void snapshot_versions () {
+        const auto first = entt::entity(7);
+        const auto recycled = entt::entity(7 | (1u << 20));
+        serval::SnapshotBuffer<Position> buffer;
+        buffer.begin();
+        buffer.capture(first, {0, 0, 0});
+        buffer.begin();
+        buffer.capture(first, {10, 0, 0});
+        Position out{};
+        CHECK(buffer.interpolate(first, 0.5f, out) && out.x == 5);
+        CHECK(!buffer.interpolate(recycled, 0.5f, out));
+
+        buffer.begin();
+        buffer.capture(recycled, {100, 0, 0});
+        CHECK(buffer.interpolate(recycled, 0.5f, out) && out.x == 100);
+        CHECK(!buffer.interpolate(first, 0.5f, out));
+    }
+}
+
+int main () {
+    clock_range();
+    snapshot_versions();
+    return serval::tests::failures() ? 1 : 0;
+}
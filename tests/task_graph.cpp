@@ -0,0 +1,149 @@
+#include "check.hpp"
+
+#include <serval/sdk/scheduling.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+    using Index = serval::TaskGraph::Index;
+
+    std::vector<Index> drain (serval::TaskGraph& graph) {
+        std::vector<Index> order;
+        Index task;
+        while (graph.pop(task)) {
+            order.push_back(task);
+        }
+        return order;
+    }
+
+    // Of the ready tasks, the one with the longest path to the end of the frame is dispatched first
+    void dispatch_order () {
+        serval::TaskGraph graph{1.0f};
+        const auto short_chain = graph.add_task();
+        const auto long_chain = graph.add_task();
+        const auto tail = graph.add_task();
+        const auto alone = graph.add_task();
+        graph.add_dependency(long_chain, tail);
+        graph.record(short_chain, 2);
+        graph.record(long_chain, 1);
+        graph.record(tail, 4);
+        graph.record(alone, 3);
+        graph.update();
+        CHECK(graph.priority(long_chain) == 5);
+        CHECK(graph.priority(tail) == 4);
+        CHECK(graph.critical_path_ms() == 5);
+        graph.begin_frame();
+        CHECK((drain(graph) == std::vector<Index>{long_chain, alone, short_chain}));
+    }
+
+    // A task becomes ready once every task it depends on has completed, and the frame finishes with the last one
+    void readiness () {
+        serval::TaskGraph graph;
+        const auto a = graph.add_task();
+        const auto b = graph.add_task();
+        const auto c = graph.add_task();
+        graph.add_dependency(a, c);
+        graph.add_dependency(b, c);
+        graph.begin_frame();
+        auto ready = drain(graph);
+        CHECK(ready.size() == 2);
+        graph.complete(a);
+        Index task;
+        CHECK(!graph.pop(task));
+        graph.complete(b);
+        CHECK(graph.pop(task) && task == c);
+        CHECK(!graph.finished());
+        graph.complete(c);
+        CHECK(graph.finished());
+
+        // The next frame starts over
+        graph.begin_frame();
+        CHECK(!graph.finished());
+        CHECK(drain(graph).size() == 2);
+    }
+
+    // Dependencies forming a cycle are rejected rather than leaving the frame unable to finish
+    void cycle () {
+        serval::TaskGraph graph;
+        const auto a = graph.add_task();
+        const auto b = graph.add_task();
+        const auto c = graph.add_task();
+        graph.add_dependency(a, b);
+        graph.add_dependency(b, c);
+        graph.add_dependency(c, b);
+        bool rejected = false;
+        try {
+            graph.update();
+        } catch (const std::logic_error&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+        rejected = false;
+        try {
+            graph.begin_frame();
+        } catch (const std::logic_error&) {
+            rejected = true;
+        }
+        CHECK(rejected);
+    }
+
+    // Workers popping and completing concurrently run every task once, each after its dependencies
+    void concurrent () {
+        serval::TaskGraph graph;
+        constexpr Index LAYERS = 50;
+        constexpr Index WIDTH = 20;
+        for (Index task = 0; task < LAYERS * WIDTH; ++task) {
+            graph.add_task();
+        }
+        for (Index layer = 1; layer < LAYERS; ++layer) {
+            for (Index index = 0; index < WIDTH; ++index) {
+                graph.add_dependency((layer - 1) * WIDTH + index, layer * WIDTH + index);
+                graph.add_dependency((layer - 1) * WIDTH + (index + 1) % WIDTH, layer * WIDTH + index);
+            }
+        }
+        std::vector<std::atomic<int>> done(LAYERS * WIDTH);
+        std::atomic<int> bad = 0;
+        graph.begin_frame();
+        std::vector<std::thread> workers;
+        for (int worker = 0; worker < 4; ++worker) {
+            workers.emplace_back([&](){
+                Index task;
+                while (!graph.finished()) {
+                    if (!graph.pop(task)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    if (task >= WIDTH) {
+                        const auto index = task % WIDTH;
+                        const auto previous = task - index - WIDTH;
+                        if (!done[previous + index].load() || !done[previous + (index + 1) % WIDTH].load()) {
+                            ++bad;
+                        }
+                    }
+                    if (done[task].fetch_add(1) != 0) {
+                        ++bad;
+                    }
+                    graph.complete(task);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        CHECK(bad == 0);
+        for (const auto& count : done) {
+            CHECK(count == 1);
+        }
+    }
+}
+
+int main () {
+    dispatch_order();
+    readiness();
+    cycle();
+    concurrent();
+    return serval::tests::failures() ? 1 : 0;
+}
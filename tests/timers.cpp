@@ -0,0 +1,168 @@
+#include "check.hpp"
+#include "../bench/mock_engine.hpp"
+
+#include <serval/sdk/timers.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace {
+    std::vector<int> g_fired;
+
+    struct Recorder {
+        int id;
+        void hit () {
+            g_fired.push_back(id);
+        }
+    };
+
+    serval::Callback callback (Recorder& recorder) {
+        serval::Callback callback;
+        callback.connect<&Recorder::hit>(&recorder);
+        return callback;
+    }
+
+    // A timer scheduled just before the low 32 bits of the tick counter wrap fires on time, not 2^32 ticks late
+    void boundary (serval::Runtime& api) {
+        serval::TimerWheel wheel{1.0};
+        Recorder recorder{0};
+        wheel.advance(double((std::uint64_t{1} << 32) - 10));
+        wheel.schedule(20, callback(recorder));
+        std::size_t fired = 0;
+        for (int tick = 0; tick < 19; ++tick) {
+            wheel.advance(1.0);
+            fired += wheel.fire(api);
+        }
+        CHECK(fired == 0);
+        CHECK(wheel.size() == 1);
+        wheel.advance(1.0);
+        CHECK(wheel.fire(api) == 1);
+        CHECK(wheel.size() == 0);
+    }
+
+    // Timers further out than the wheel's range wait at the top level and still fire on time
+    void beyond_range (serval::Runtime& api) {
+        serval::TimerWheel wheel{1.0};
+        Recorder recorder{0};
+        const std::uint64_t delay = (std::uint64_t{1} << 33) + 4096;
+        wheel.advance(12345.0);
+        wheel.schedule(serval::Scalar(delay), callback(recorder));
+        std::uint64_t elapsed = 0;
+        std::size_t fired = 0;
+        for (; elapsed + 1000000 < delay; elapsed += 1000000) {
+            wheel.advance(1000000.0);
+            fired += wheel.fire(api);
+        }
+        CHECK(fired == 0);
+        while (elapsed < delay) {
+            wheel.advance(1.0);
+            ++elapsed;
+            fired += wheel.fire(api);
+            CHECK(fired == (elapsed == delay ? 1 : 0));
+        }
+    }
+
+    // Timers due on the same tick fire in the order they were scheduled, including after cascading down a level
+    void tie_order (serval::Runtime& api) {
+        Recorder recorders[4] = {{0}, {1}, {2}, {3}};
+        serval::TimerWheel wheel{1.0};
+        wheel.advance(250.0);
+        wheel.schedule(10, callback(recorders[0]));
+        wheel.schedule(10, callback(recorders[1]));
+        wheel.schedule(10, callback(recorders[2]));
+        wheel.advance(8.0);
+        wheel.schedule(2, callback(recorders[3]));
+        g_fired.clear();
+        wheel.advance(5.0);
+        wheel.fire(api);
+        CHECK((g_fired == std::vector<int>{0, 1, 2, 3}));
+
+        serval::TimerWheel cascaded{1.0};
+        cascaded.advance(100.0);
+        cascaded.schedule(1000, callback(recorders[0]));
+        cascaded.advance(990.0);
+        cascaded.schedule(10, callback(recorders[1]));
+        g_fired.clear();
+        cascaded.advance(20.0);
+        cascaded.fire(api);
+        CHECK((g_fired == std::vector<int>{0, 1}));
+    }
+
+    // Cancelling a timer which is due but not yet fired stops it firing and removes it from size()
+    void cancel_due (serval::Runtime& api) {
+        serval::TimerWheel wheel{1.0};
+        Recorder recorder{0};
+        const auto timer = wheel.schedule(1, callback(recorder));
+        wheel.schedule(1, callback(recorder));
+        wheel.advance(2.0);
+        CHECK(wheel.size() == 2);
+        CHECK(wheel.cancel(timer));
+        CHECK(wheel.size() == 1);
+        CHECK(wheel.fire(api) == 1);
+        CHECK(wheel.size() == 0);
+    }
+
+    struct Clearer {
+        serval::TimerWheel* wheel;
+        void hit () {
+            g_fired.push_back(-1);
+            wheel->clear();
+        }
+    };
+
+    // Clearing from a timer cancels the rest of its batch, and the wheel keeps working afterwards
+    void clear_while_firing (serval::Runtime& api) {
+        serval::TimerWheel wheel{1.0};
+        Clearer clearer{&wheel};
+        Recorder recorder{0};
+        serval::Callback clear;
+        clear.connect<&Clearer::hit>(&clearer);
+        wheel.schedule(1, clear);
+        const auto timer = wheel.schedule(1, callback(recorder));
+        wheel.schedule(5, callback(recorder));
+        wheel.advance(2.0);
+        g_fired.clear();
+        CHECK(wheel.fire(api) == 1);
+        CHECK((g_fired == std::vector<int>{-1}));
+        CHECK(!wheel.pending(timer));
+        CHECK(wheel.size() == 0);
+        wheel.schedule(1, callback(recorder));
+        CHECK(wheel.size() == 1);
+        wheel.advance(10.0);
+        CHECK(wheel.fire(api) == 1);
+        CHECK(wheel.size() == 0);
+    }
+
+    // Negative, infinite and NaN times neither run the clock backwards nor overflow the tick counter
+    void out_of_range (serval::Runtime& api) {
+        serval::TimerWheel wheel{1.0};
+        Recorder recorder{0};
+        wheel.schedule(-5, callback(recorder));
+        wheel.schedule(std::numeric_limits<serval::Scalar>::quiet_NaN(), callback(recorder));
+        const auto never = wheel.schedule(std::numeric_limits<serval::Scalar>::infinity(), callback(recorder));
+        wheel.advance(-10.0);
+        wheel.advance(std::numeric_limits<double>::quiet_NaN());
+        CHECK(wheel.fire(api) == 0);
+        wheel.advance(1.0);
+        CHECK(wheel.fire(api) == 2);
+        wheel.advance(1e9);
+        CHECK(wheel.fire(api) == 0);
+        CHECK(wheel.cancel(never));
+        wheel.schedule(3, callback(recorder));
+        wheel.advance(std::numeric_limits<double>::infinity());
+        CHECK(wheel.fire(api) == 1);
+        CHECK(wheel.size() == 0);
+    }
+}
+
+int main () {
+    serval::bench::MockRuntime api;
+    boundary(api);
+    beyond_range(api);
+    tie_order(api);
+    cancel_due(api);
+    clear_while_firing(api);
+    out_of_range(api);
+    return serval::tests::failures() ? 1 : 0;
+}